@@ -2,4 +2,7 @@ import { nextEvent, sendResponse } from "lambda"
 import { handler } from "./lambda.js"
 
 const event = nextEvent()
+
+// Async handlers return a promise, which sendResponse() waits for. Handlers
+// that streamed their response with startResponse() return nothing.
 sendResponse(handler(event))
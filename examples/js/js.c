@@ -52,6 +52,21 @@ static int eval_buf(JSContext *ctx, const void *buf, int buf_len,
     return ret;
 }
 
+static int eval_bundle(JSContext *ctx) {
+    JSValue val;
+    int ret;
+
+    val = js_std_eval_bundle(ctx);
+    if (JS_IsException(val)) {
+        js_std_dump_error(ctx);
+        ret = -1;
+    } else {
+        ret = 0;
+    }
+    JS_FreeValue(ctx, val);
+    return ret;
+}
+
 static int eval_file(JSContext *ctx, const char *filename) {
     uint8_t *buf;
     int ret, eval_flags;
@@ -63,6 +78,11 @@ static int eval_file(JSContext *ctx, const char *filename) {
         exit(1);
     }
 
+    /* the imports of a bundle are resolved from the same buffer, so
+       it is kept until the end */
+    if (js_std_set_bundle(ctx, buf, buf_len) == 0)
+        return eval_bundle(ctx);
+
     ret = eval_buf(ctx, buf, buf_len, filename, JS_EVAL_TYPE_MODULE);
     js_free(ctx, buf);
     return ret;
@@ -76,7 +96,16 @@ static char *path_parent(const char *script_path) {
     return NULL;
 }
 
+/* The response is only read by the server once the script has exited,
+   so stdout is flushed at exit, when std.out.flush() is called or when
+   this buffer is full. Each flush is a single vectored fd_write(). */
+#define STDOUT_BUF_SIZE (64 * 1024)
+
+static char stdout_buf[STDOUT_BUF_SIZE];
+
 int main(int argc, char *argv[]) {
+    setvbuf(stdout, stdout_buf, _IOFBF, sizeof(stdout_buf));
+
     const char *script_path = getenv("SCRIPT_NAME");
     if (script_path) {
         char *parent = path_parent(script_path);
@@ -95,12 +124,22 @@ int main(int argc, char *argv[]) {
 
     int ret = 0;
     const char *path = getenv("PATH_INFO");
-    if (path && *path != '\0') {
+    if (argc == 4 && !strcmp(argv[1], "--bundle")) {
+        /* js.wasm --bundle out.jsb main.js */
+        ret = js_std_write_bundle(ctx, argv[2], argv[3]);
+        if (ret)
+            js_std_dump_error(ctx);
+    } else if (path && *path != '\0') {
         ret = eval_file(ctx, path + 1);
+        /* run the promise jobs and the timers left by the script */
+        js_std_loop(ctx);
     } else {
         ret = 1;
     }
 
+    if (getenv("JS_GC_STATS"))
+        js_std_dump_gc_stats(rt, stderr);
+
     js_std_free_handlers(rt);
     JS_FreeContext(ctx);
     JS_FreeRuntime(rt);
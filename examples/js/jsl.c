@@ -42,6 +42,9 @@ int main(int argc, char *argv[]) {
     JSRuntime *rt = JS_NewRuntime();
     js_std_init_handlers(rt);
     JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    /* a rejected async handler sends no response, log why */
+    JS_SetHostPromiseRejectionTracker(rt, js_std_promise_rejection_tracker,
+                                      NULL);
 
     JSContext *ctx = JS_NewContext(rt);
     js_std_add_helpers(ctx, argc, argv);
@@ -49,7 +52,17 @@ int main(int argc, char *argv[]) {
     js_init_module_os(ctx, "os");
     js_init_module_lambda(ctx, "lambda");
 
+    /* handlers mostly allocate short lived objects: do not rescan the
+       runtime objects on each collection, and bound the GC pauses seen
+       by the client to about 1ms */
+    JS_SetGCGenerational(rt, 1);
+    JS_SetGCSliceTime(rt, 1000);
+
     int ret = eval_bootstrap(ctx);
+    js_std_loop(ctx);
+
+    if (getenv("JS_GC_STATS"))
+        js_std_dump_gc_stats(rt, stderr);
 
     js_std_free_handlers(rt);
     JS_FreeContext(ctx);
@@ -11,4 +11,47 @@ uint32_t lambda_event_size()
 int32_t lambda_send_response(const char *buf, uint32_t buf_size)
     __attribute__((import_module("lambda0"), import_name("lambda_send_response")));
 
+/* Streamed responses: send the status and a JSON object of headers (names to
+ * lists of values) first, then any number of body chunks, then finish. */
+int32_t lambda_response_start(uint32_t status_code, const char *headers,
+                              uint32_t headers_size)
+    __attribute__((import_module("lambda0"), import_name("lambda_response_start")));
+int32_t lambda_response_write(const char *buf, uint32_t buf_size)
+    __attribute__((import_module("lambda0"), import_name("lambda_response_write")));
+int32_t lambda_response_finish()
+    __attribute__((import_module("lambda0"), import_name("lambda_response_finish")));
+
+/* Binary event layout served by the lambda1 imports. All integers are little
+ * endian and all offsets are relative to the start of the event. Strings are
+ * not NUL terminated. Repeated headers and query parameters are stored as
+ * adjacent pairs with the same name. */
+
+#define LAMBDA_EVENT_VERSION 1
+#define LAMBDA_EVENT_BODY_UTF8 (1 << 0)
+
+typedef struct lambda_slice {
+    uint32_t offset;
+    uint32_t len;
+} lambda_slice_t;
+
+typedef struct lambda_pair {
+    lambda_slice_t name;
+    lambda_slice_t value;
+} lambda_pair_t;
+
+typedef struct lambda_event_header {
+    uint32_t version;
+    uint32_t flags;
+    lambda_slice_t method;
+    lambda_slice_t path;
+    lambda_slice_t body;
+    lambda_slice_t headers; /* offset of a lambda_pair_t table, and its length */
+    lambda_slice_t query;   /* offset of a lambda_pair_t table, and its length */
+} lambda_event_header_t;
+
+uint32_t lambda1_event(char *buf, uint32_t buf_size)
+    __attribute__((import_module("lambda1"), import_name("lambda_event")));
+uint32_t lambda1_event_size()
+    __attribute__((import_module("lambda1"), import_name("lambda_event_size")));
+
 #endif
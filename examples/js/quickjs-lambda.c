@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,45 +8,864 @@
 #include "quickjs-lambda.h"
 #include "quickjs.h"
 
-static char *event_buf = NULL;
-static size_t event_buf_len = 0;
+/* Events are kept as received and only decoded into JS values when a field is
+ * first read. The fields are own enumerable properties provided by the exotic
+ * methods of the event class, so that spreading or serializing an event sees
+ * all of them, while handlers that only look at a couple of headers never pay
+ * for the rest of the event. */
+
+typedef struct {
+    JSAtom atom; /* JS_ATOM_NULL once deleted */
+    int flags;   /* JS_PROP_C_W_E and JS_PROP_GETSET */
+    JSValue val; /* JS_UNINITIALIZED until the field is first read */
+    JSValue getter, setter;
+#ifndef CONFIG_LAMBDA1
+    lambda_slice_t value; /* span of the field's JSON value */
+#endif
+} JSLambdaEventField;
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t len;
+    JSLambdaEventField *fields;
+    uint32_t field_count;
+    uint32_t field_size;
+} JSLambdaEvent;
+
+static JSClassID js_lambda_event_class_id;
+
+static void js_lambda_event_free(JSRuntime *rt, JSLambdaEvent *e) {
+    uint32_t i;
+
+    for (i = 0; i < e->field_count; i++) {
+        JS_FreeAtomRT(rt, e->fields[i].atom);
+        JS_FreeValueRT(rt, e->fields[i].val);
+        JS_FreeValueRT(rt, e->fields[i].getter);
+        JS_FreeValueRT(rt, e->fields[i].setter);
+    }
+    js_free_rt(rt, e->fields);
+    js_free_rt(rt, e->buf);
+    js_free_rt(rt, e);
+}
+
+static void js_lambda_event_finalizer(JSRuntime *rt, JSValue val) {
+    JSLambdaEvent *e = JS_GetOpaque(val, js_lambda_event_class_id);
+    if (e)
+        js_lambda_event_free(rt, e);
+}
+
+static void js_lambda_event_mark(JSRuntime *rt, JSValueConst val,
+                                 JS_MarkFunc *mark_func) {
+    JSLambdaEvent *e = JS_GetOpaque(val, js_lambda_event_class_id);
+    uint32_t i;
+
+    if (e) {
+        for (i = 0; i < e->field_count; i++) {
+            JS_MarkValue(rt, e->fields[i].val, mark_func);
+            JS_MarkValue(rt, e->fields[i].getter, mark_func);
+            JS_MarkValue(rt, e->fields[i].setter, mark_func);
+        }
+    }
+}
+
+/* Takes over 'atom'. A repeated name reuses the field of the first one. */
+static JSLambdaEventField *
+js_lambda_event_add_field(JSContext *ctx, JSLambdaEvent *e, JSAtom atom) {
+    JSLambdaEventField *fields, *f;
+    uint32_t i, new_size;
+
+    for (i = 0; i < e->field_count; i++) {
+        if (e->fields[i].atom == atom) {
+            JS_FreeAtom(ctx, atom);
+            return &e->fields[i];
+        }
+    }
+
+    if (e->field_count == e->field_size) {
+        new_size = max_int(8, e->field_size * 2);
+        fields = js_realloc(ctx, e->fields, sizeof(*fields) * new_size);
+        if (!fields) {
+            JS_FreeAtom(ctx, atom);
+            return NULL;
+        }
+        e->fields = fields;
+        e->field_size = new_size;
+    }
+    f = &e->fields[e->field_count++];
+    memset(f, 0, sizeof(*f));
+    f->atom = atom;
+    f->flags = JS_PROP_C_W_E;
+    f->val = JS_UNINITIALIZED;
+    f->getter = JS_UNDEFINED;
+    f->setter = JS_UNDEFINED;
+    return f;
+}
+
+#ifdef CONFIG_LAMBDA1
+
+enum {
+    LAMBDA_EVENT_RESOURCE,
+    LAMBDA_EVENT_PATH,
+    LAMBDA_EVENT_HTTP_METHOD,
+    LAMBDA_EVENT_HEADERS,
+    LAMBDA_EVENT_QUERY,
+    LAMBDA_EVENT_PATH_PARAMETERS,
+    LAMBDA_EVENT_STAGE_VARIABLES,
+    LAMBDA_EVENT_BODY,
+    LAMBDA_EVENT_IS_BASE64_ENCODED,
+};
+
+/* the fields of a binary event, in the order of the enum */
+static const char *const js_lambda_event_fields[] = {
+    [LAMBDA_EVENT_RESOURCE] = "resource",
+    [LAMBDA_EVENT_PATH] = "path",
+    [LAMBDA_EVENT_HTTP_METHOD] = "httpMethod",
+    [LAMBDA_EVENT_HEADERS] = "headers",
+    [LAMBDA_EVENT_QUERY] = "queryStringParameters",
+    [LAMBDA_EVENT_PATH_PARAMETERS] = "pathParameters",
+    [LAMBDA_EVENT_STAGE_VARIABLES] = "stageVariables",
+    [LAMBDA_EVENT_BODY] = "body",
+    [LAMBDA_EVENT_IS_BASE64_ENCODED] = "isBase64Encoded",
+};
+
+static uint32_t js_lambda_event_size(void) { return lambda1_event_size(); }
+
+static uint32_t js_lambda_event_read(uint8_t *buf, uint32_t len) {
+    return lambda1_event((char *)buf, len);
+}
+
+static inline const lambda_event_header_t *
+js_lambda_event_header(const JSLambdaEvent *e) {
+    return (const lambda_event_header_t *)e->buf;
+}
+
+static inline const lambda_pair_t *
+js_lambda_event_pairs(const JSLambdaEvent *e, lambda_slice_t table) {
+    return (const lambda_pair_t *)(e->buf + table.offset);
+}
+
+static bool js_lambda_slice_valid(const JSLambdaEvent *e, lambda_slice_t s) {
+    return s.offset <= e->len && s.len <= e->len - s.offset;
+}
+
+static bool js_lambda_table_valid(const JSLambdaEvent *e, lambda_slice_t table) {
+    const lambda_pair_t *pairs;
+    uint32_t i;
+
+    if (table.offset % sizeof(uint32_t) != 0 || table.offset > e->len ||
+        table.len > (e->len - table.offset) / sizeof(lambda_pair_t))
+        return false;
+
+    pairs = js_lambda_event_pairs(e, table);
+    for (i = 0; i < table.len; i++) {
+        if (!js_lambda_slice_valid(e, pairs[i].name) ||
+            !js_lambda_slice_valid(e, pairs[i].value))
+            return false;
+    }
+    return true;
+}
+
+/* Check every offset once up front, so decoding can trust the layout. */
+static int js_lambda_event_index(JSContext *ctx, JSLambdaEvent *e) {
+    const lambda_event_header_t *h = js_lambda_event_header(e);
+    JSAtom atom;
+    uint32_t i;
+
+    if (e->len < sizeof(*h) || h->version != LAMBDA_EVENT_VERSION ||
+        !js_lambda_slice_valid(e, h->method) ||
+        !js_lambda_slice_valid(e, h->path) ||
+        !js_lambda_slice_valid(e, h->body) ||
+        !js_lambda_table_valid(e, h->headers) ||
+        !js_lambda_table_valid(e, h->query)) {
+        JS_ThrowTypeError(ctx, "malformed lambda event");
+        return -1;
+    }
+
+    for (i = 0; i < countof(js_lambda_event_fields); i++) {
+        atom = JS_NewAtom(ctx, js_lambda_event_fields[i]);
+        if (atom == JS_ATOM_NULL || !js_lambda_event_add_field(ctx, e, atom))
+            return -1;
+    }
+    return 0;
+}
+
+static JSValue js_lambda_event_string(JSContext *ctx, const JSLambdaEvent *e,
+                                      lambda_slice_t s) {
+    return JS_NewStringLen(ctx, (const char *)e->buf + s.offset, s.len);
+}
+
+static bool js_lambda_slice_equal(const JSLambdaEvent *e, lambda_slice_t a,
+                                  lambda_slice_t b) {
+    return a.len == b.len &&
+           memcmp(e->buf + a.offset, e->buf + b.offset, a.len) == 0;
+}
+
+/* Builds a { name: [value, ...] } object out of a pair table. */
+static JSValue js_lambda_event_multi_map(JSContext *ctx, const JSLambdaEvent *e,
+                                         lambda_slice_t table) {
+    const lambda_pair_t *pairs = js_lambda_event_pairs(e, table);
+    JSValue obj, values, val;
+    JSAtom atom;
+    uint32_t i, j;
+
+    obj = JS_NewObject(ctx);
+    if (JS_IsException(obj))
+        return obj;
+
+    for (i = 0; i < table.len; i += j) {
+        values = JS_NewArray(ctx);
+        if (JS_IsException(values))
+            goto fail;
+
+        for (j = 0; i + j < table.len &&
+                    js_lambda_slice_equal(e, pairs[i].name, pairs[i + j].name);
+             j++) {
+            val = js_lambda_event_string(ctx, e, pairs[i + j].value);
+            if (JS_IsException(val) ||
+                JS_SetPropertyUint32(ctx, values, j, val) < 0) {
+                JS_FreeValue(ctx, values);
+                goto fail;
+            }
+        }
+
+        atom = JS_NewAtomLen(ctx, (const char *)e->buf + pairs[i].name.offset,
+                             pairs[i].name.len);
+        if (atom == JS_ATOM_NULL) {
+            JS_FreeValue(ctx, values);
+            goto fail;
+        }
+        if (JS_DefinePropertyValue(ctx, obj, atom, values, JS_PROP_C_W_E) < 0) {
+            JS_FreeAtom(ctx, atom);
+            goto fail;
+        }
+        JS_FreeAtom(ctx, atom);
+    }
+    return obj;
+
+fail:
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+}
+
+static JSValue js_lambda_event_decode(JSContext *ctx, JSLambdaEvent *e,
+                                      uint32_t field) {
+    const lambda_event_header_t *h = js_lambda_event_header(e);
+
+    switch (field) {
+    case LAMBDA_EVENT_RESOURCE:
+    case LAMBDA_EVENT_PATH:
+        return js_lambda_event_string(ctx, e, h->path);
+    case LAMBDA_EVENT_HTTP_METHOD:
+        return js_lambda_event_string(ctx, e, h->method);
+    case LAMBDA_EVENT_HEADERS:
+        return js_lambda_event_multi_map(ctx, e, h->headers);
+    case LAMBDA_EVENT_QUERY:
+        return js_lambda_event_multi_map(ctx, e, h->query);
+    case LAMBDA_EVENT_BODY:
+        /* Binary bodies are handed over as is, there is no need to base64
+           encode them like the JSON event does. */
+        if (h->flags & LAMBDA_EVENT_BODY_UTF8)
+            return js_lambda_event_string(ctx, e, h->body);
+        return JS_NewArrayBufferCopy(ctx, e->buf + h->body.offset,
+                                     h->body.len);
+    case LAMBDA_EVENT_IS_BASE64_ENCODED:
+        return JS_FALSE;
+    default:
+        return JS_NULL;
+    }
+}
+
+#else
+
+static uint32_t js_lambda_event_size(void) { return lambda_event_size(); }
+
+static uint32_t js_lambda_event_read(uint8_t *buf, uint32_t len) {
+    return lambda_event((char *)buf, len);
+}
+
+static const uint8_t *json_skip_ws(const uint8_t *p, const uint8_t *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+        p++;
+    return p;
+}
+
+/* p points at the opening quote, returns the position after the closing
+   one. */
+static const uint8_t *json_skip_string(const uint8_t *p, const uint8_t *end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\')
+            p++;
+        else if (*p == '"')
+            return p + 1;
+    }
+    return NULL;
+}
+
+/* Skips over a single value without decoding it. Primitives end at the next
+   separator, so their span may include trailing whitespace. */
+static const uint8_t *json_skip_value(const uint8_t *p, const uint8_t *end) {
+    int depth = 0;
+
+    while (p < end) {
+        switch (*p) {
+        case '"':
+            p = json_skip_string(p, end);
+            if (!p || depth == 0)
+                return p;
+            continue;
+        case '{':
+        case '[':
+            depth++;
+            break;
+        case '}':
+        case ']':
+            if (depth == 0)
+                return p;
+            if (--depth == 0)
+                return p + 1;
+            break;
+        case ',':
+            if (depth == 0)
+                return p;
+            break;
+        }
+        p++;
+    }
+    return depth == 0 ? p : NULL;
+}
+
+/* Returns the atom of a quoted key. */
+static JSAtom js_lambda_event_key(JSContext *ctx, uint8_t *key, size_t len) {
+    JSValue val;
+    JSAtom atom;
+    uint8_t c;
+
+    if (!memchr(key + 1, '\\', len - 2))
+        return JS_NewAtomLen(ctx, (const char *)key + 1, len - 2);
+
+    /* see js_lambda_event_decode() */
+    c = key[len];
+    key[len] = '\0';
+    val = JS_ParseJSON(ctx, (const char *)key, len, "<lambda event>");
+    key[len] = c;
+    if (JS_IsException(val))
+        return JS_ATOM_NULL;
+    atom = JS_ValueToAtom(ctx, val);
+    JS_FreeValue(ctx, val);
+    return atom;
+}
+
+/* Records where each top level field's value lives, without parsing any of
+   them. */
+static int js_lambda_event_index(JSContext *ctx, JSLambdaEvent *e) {
+    uint8_t *start = e->buf, *end = e->buf + e->len;
+    uint8_t *p, *key, *value;
+    JSLambdaEventField *f;
+    JSAtom atom;
+
+    p = (uint8_t *)json_skip_ws(start, end);
+    if (p == end || *p != '{')
+        goto malformed;
+    p = (uint8_t *)json_skip_ws(p + 1, end);
+    if (p < end && *p == '}')
+        return 0;
+
+    for (;;) {
+        if (p == end || *p != '"')
+            goto malformed;
+        key = p;
+        p = (uint8_t *)json_skip_string(p, end);
+        if (!p)
+            goto malformed;
+        atom = js_lambda_event_key(ctx, key, p - key);
+        if (atom == JS_ATOM_NULL)
+            return -1;
+        f = js_lambda_event_add_field(ctx, e, atom);
+        if (!f)
+            return -1;
+
+        p = (uint8_t *)json_skip_ws(p, end);
+        if (p == end || *p != ':')
+            goto malformed;
+        value = (uint8_t *)json_skip_ws(p + 1, end);
+        p = (uint8_t *)json_skip_value(value, end);
+        if (!p || p == value)
+            goto malformed;
+        /* the last of repeated keys wins, as with JSON.parse() */
+        f->value.offset = value - start;
+        f->value.len = p - value;
+
+        p = (uint8_t *)json_skip_ws(p, end);
+        if (p == end)
+            goto malformed;
+        if (*p == '}')
+            return 0;
+        if (*p != ',')
+            goto malformed;
+        p = (uint8_t *)json_skip_ws(p + 1, end);
+    }
+
+malformed:
+    JS_ThrowTypeError(ctx, "malformed lambda event");
+    return -1;
+}
+
+static JSValue js_lambda_event_decode(JSContext *ctx, JSLambdaEvent *e,
+                                      uint32_t field) {
+    lambda_slice_t s = e->fields[field].value;
+    char *p, c;
+    JSValue val;
+
+    /* JS_ParseJSON wants a NUL terminated input, so cut the event short right
+       after the value while it is parsed. */
+    p = (char *)e->buf + s.offset;
+    c = p[s.len];
+    p[s.len] = '\0';
+    val = JS_ParseJSON(ctx, p, s.len, "<lambda event>");
+    p[s.len] = c;
+    return val;
+}
+
+#endif /* CONFIG_LAMBDA1 */
+
+/* Returns the index of the field named 'prop', or -1. */
+static int js_lambda_event_find(JSLambdaEvent *e, JSAtom prop) {
+    uint32_t i;
+
+    for (i = 0; i < e->field_count; i++) {
+        if (e->fields[i].atom == prop)
+            return i;
+    }
+    return -1;
+}
+
+/* Decodes the field on first use. */
+static JSValue js_lambda_event_value(JSContext *ctx, JSLambdaEvent *e,
+                                     uint32_t field) {
+    JSValue val;
+
+    if (JS_IsUninitialized(e->fields[field].val)) {
+        val = js_lambda_event_decode(ctx, e, field);
+        if (JS_IsException(val))
+            return val;
+        e->fields[field].val = val;
+    }
+    return JS_DupValue(ctx, e->fields[field].val);
+}
+
+static int js_lambda_event_get_own_property(JSContext *ctx,
+                                            JSPropertyDescriptor *desc,
+                                            JSValueConst obj, JSAtom prop) {
+    JSLambdaEvent *e = JS_GetOpaque(obj, js_lambda_event_class_id);
+    JSLambdaEventField *f;
+    JSValue val;
+    int i;
+
+    if (!e || (i = js_lambda_event_find(e, prop)) < 0)
+        return false;
+
+    if (desc) {
+        f = &e->fields[i];
+        if (f->flags & JS_PROP_GETSET) {
+            desc->value = JS_UNDEFINED;
+            desc->getter = JS_DupValue(ctx, f->getter);
+            desc->setter = JS_DupValue(ctx, f->setter);
+        } else {
+            val = js_lambda_event_value(ctx, e, i);
+            if (JS_IsException(val))
+                return -1;
+            desc->value = val;
+            desc->getter = JS_UNDEFINED;
+            desc->setter = JS_UNDEFINED;
+        }
+        desc->flags = f->flags;
+    }
+    return true;
+}
+
+static int js_lambda_event_get_own_property_names(JSContext *ctx,
+                                                  JSPropertyEnum **ptab,
+                                                  uint32_t *plen,
+                                                  JSValueConst obj) {
+    JSLambdaEvent *e = JS_GetOpaque(obj, js_lambda_event_class_id);
+    JSPropertyEnum *tab;
+    uint32_t i, len, count;
+
+    count = e ? e->field_count : 0;
+    tab = js_malloc(ctx, sizeof(*tab) * max_int(count, 1));
+    if (!tab)
+        return -1;
+
+    len = 0;
+    for (i = 0; i < count; i++) {
+        if (e->fields[i].atom != JS_ATOM_NULL) {
+            tab[len].is_enumerable =
+                (e->fields[i].flags & JS_PROP_ENUMERABLE) != 0;
+            tab[len].atom = JS_DupAtom(ctx, e->fields[i].atom);
+            len++;
+        }
+    }
+    *ptab = tab;
+    *plen = len;
+    return 0;
+}
+
+/* Replaces *pval by a copy of 'val'. */
+static void js_lambda_event_set_value(JSContext *ctx, JSValue *pval,
+                                      JSValueConst val) {
+    JSValue old = *pval;
+    *pval = JS_DupValue(ctx, val);
+    JS_FreeValue(ctx, old);
+}
+
+static int js_lambda_event_delete_property(JSContext *ctx, JSValueConst obj,
+                                           JSAtom prop) {
+    JSLambdaEvent *e = JS_GetOpaque(obj, js_lambda_event_class_id);
+    JSLambdaEventField *f;
+    int i;
+
+    if (!e || (i = js_lambda_event_find(e, prop)) < 0)
+        return true;
+
+    f = &e->fields[i];
+    if (!(f->flags & JS_PROP_CONFIGURABLE))
+        return false;
+    JS_FreeAtom(ctx, f->atom);
+    f->atom = JS_ATOM_NULL;
+    js_lambda_event_set_value(ctx, &f->val, JS_UNDEFINED);
+    js_lambda_event_set_value(ctx, &f->getter, JS_UNDEFINED);
+    js_lambda_event_set_value(ctx, &f->setter, JS_UNDEFINED);
+    return true;
+}
+
+/* Object.defineProperty() on a field, following the checks QuickJS does for
+   ordinary properties. Anything else is left to the ordinary object. */
+static int js_lambda_event_define_own_property(JSContext *ctx,
+                                               JSValueConst this_obj,
+                                               JSAtom prop, JSValueConst val,
+                                               JSValueConst getter,
+                                               JSValueConst setter, int flags) {
+    JSLambdaEvent *e = JS_GetOpaque(this_obj, js_lambda_event_class_id);
+    JSLambdaEventField *f;
+    JSValue cur;
+    int i, mask, same, is_accessor, is_data;
+
+    if (!e || (i = js_lambda_event_find(e, prop)) < 0)
+        return JS_DefineProperty(ctx, this_obj, prop, val, getter, setter,
+                                 flags | JS_PROP_NO_EXOTIC);
+
+    f = &e->fields[i];
+    is_accessor = flags & (JS_PROP_HAS_GET | JS_PROP_HAS_SET);
+    is_data = flags & (JS_PROP_HAS_VALUE | JS_PROP_HAS_WRITABLE);
+
+    if (!(f->flags & JS_PROP_CONFIGURABLE)) {
+        if ((flags & JS_PROP_HAS_CONFIGURABLE) &&
+            (flags & JS_PROP_CONFIGURABLE))
+            goto not_configurable;
+        if ((flags & JS_PROP_HAS_ENUMERABLE) &&
+            ((flags ^ f->flags) & JS_PROP_ENUMERABLE))
+            goto not_configurable;
+        if (f->flags & JS_PROP_GETSET) {
+            if (is_data)
+                goto not_configurable;
+            if ((flags & JS_PROP_HAS_GET) &&
+                !JS_IsSameValue(ctx, getter, f->getter))
+                goto not_configurable;
+            if ((flags & JS_PROP_HAS_SET) &&
+                !JS_IsSameValue(ctx, setter, f->setter))
+                goto not_configurable;
+        } else {
+            if (is_accessor)
+                goto not_configurable;
+            if (!(f->flags & JS_PROP_WRITABLE)) {
+                if ((flags & JS_PROP_HAS_WRITABLE) &&
+                    (flags & JS_PROP_WRITABLE))
+                    goto not_configurable;
+                if (flags & JS_PROP_HAS_VALUE) {
+                    cur = js_lambda_event_value(ctx, e, i);
+                    if (JS_IsException(cur))
+                        return -1;
+                    same = JS_IsSameValue(ctx, val, cur);
+                    JS_FreeValue(ctx, cur);
+                    if (!same)
+                        goto not_configurable;
+                }
+            }
+        }
+    }
+
+    if (is_accessor && !(f->flags & JS_PROP_GETSET)) {
+        js_lambda_event_set_value(ctx, &f->val, JS_UNDEFINED);
+        f->flags = (f->flags & ~JS_PROP_WRITABLE) | JS_PROP_GETSET;
+    } else if (is_data && (f->flags & JS_PROP_GETSET)) {
+        js_lambda_event_set_value(ctx, &f->getter, JS_UNDEFINED);
+        js_lambda_event_set_value(ctx, &f->setter, JS_UNDEFINED);
+        f->flags &= ~JS_PROP_GETSET;
+    }
+
+    if (f->flags & JS_PROP_GETSET) {
+        if (flags & JS_PROP_HAS_GET)
+            js_lambda_event_set_value(ctx, &f->getter, getter);
+        if (flags & JS_PROP_HAS_SET)
+            js_lambda_event_set_value(ctx, &f->setter, setter);
+    } else if (flags & JS_PROP_HAS_VALUE) {
+        js_lambda_event_set_value(ctx, &f->val, val);
+    }
+
+    mask = (flags >> JS_PROP_HAS_SHIFT) & JS_PROP_C_W_E;
+    if (f->flags & JS_PROP_GETSET)
+        mask &= ~JS_PROP_WRITABLE;
+    f->flags = (f->flags & ~mask) | (flags & mask);
+    return true;
+
+not_configurable:
+    if (flags & (JS_PROP_THROW | JS_PROP_THROW_STRICT)) {
+        JS_ThrowTypeError(ctx, "property is not configurable");
+        return -1;
+    }
+    return false;
+}
+
+static JSClassExoticMethods js_lambda_event_exotic_methods = {
+    .get_own_property = js_lambda_event_get_own_property,
+    .get_own_property_names = js_lambda_event_get_own_property_names,
+    .delete_property = js_lambda_event_delete_property,
+    .define_own_property = js_lambda_event_define_own_property,
+};
+
+static JSClassDef js_lambda_event_class = {
+    "LambdaEvent",
+    .finalizer = js_lambda_event_finalizer,
+    .gc_mark = js_lambda_event_mark,
+    .exotic = &js_lambda_event_exotic_methods,
+};
 
 static JSValue js_lambda_next_event(JSContext *ctx, JSValueConst this_val,
                                     int argc, JSValueConst *argv) {
-    uint32_t len = lambda_event_size() + 1;
-    if (!len) {
-        return JS_TAG_NULL;
+    uint32_t len = js_lambda_event_size();
+    JSLambdaEvent *e;
+    JSValue obj;
+
+    e = js_mallocz(ctx, sizeof(*e));
+    if (!e)
+        return JS_EXCEPTION;
+
+    /* one extra byte to keep the event NUL terminated */
+    e->buf = js_malloc(ctx, len + 1);
+    if (!e->buf) {
+        js_free(ctx, e);
+        return JS_EXCEPTION;
     }
 
-    if (len > event_buf_len) {
-        event_buf_len = len;
-        event_buf = realloc(event_buf, event_buf_len);
+    e->len = js_lambda_event_read(e->buf, len);
+    e->buf[e->len] = '\0';
+    if (js_lambda_event_index(ctx, e) < 0) {
+        js_lambda_event_free(JS_GetRuntime(ctx), e);
+        return JS_EXCEPTION;
     }
 
-    memset(event_buf, 0, event_buf_len);
-    uint32_t nbytes_r = lambda_event(event_buf, event_buf_len);
-    return JS_ParseJSON(ctx, event_buf, nbytes_r, "<lambda event>");
+    obj = JS_NewObjectClass(ctx, js_lambda_event_class_id);
+    if (JS_IsException(obj)) {
+        js_lambda_event_free(JS_GetRuntime(ctx), e);
+        return obj;
+    }
+    JS_SetOpaque(obj, e);
+    return obj;
 }
 
+/* sendResponse() also accepts the promise returned by an async handler.
+ * The response is sent once it is resolved, while js_std_loop() runs the
+ * pending jobs and the timers. undefined means that the handler streamed
+ * its response with startResponse(). */
 static JSValue js_lambda_send_response(JSContext *ctx, JSValueConst this_val,
                                        int argc, JSValueConst *argv) {
-    JSValue json = JS_JSONStringify(ctx, argv[0], JS_NULL, JS_NULL);
+    JSValueConst response = argv[0];
+    JSValue then, func, ret;
+
+    if (JS_IsUndefined(response))
+        return JS_UNDEFINED;
 
-    const char *str = JS_ToCString(ctx, json);
-    size_t len = strlen(str);
+    if (JS_IsObject(response)) {
+        then = JS_GetPropertyStr(ctx, response, "then");
+        if (JS_IsException(then))
+            return then;
+        if (JS_IsFunction(ctx, then)) {
+            func = JS_NewCFunction(ctx, js_lambda_send_response,
+                                   "sendResponse", 1);
+            if (JS_IsException(func)) {
+                JS_FreeValue(ctx, then);
+                return func;
+            }
+            ret = JS_Call(ctx, then, response, 1, (JSValueConst *)&func);
+            JS_FreeValue(ctx, func);
+            JS_FreeValue(ctx, then);
+            return ret;
+        }
+        JS_FreeValue(ctx, then);
+    }
+
+    size_t len;
+    char *str = JS_JSONStringifyUTF8(ctx, &len, response);
+    if (!str)
+        return JS_EXCEPTION;
 
     int err = lambda_send_response(str, len);
 
-    JS_FreeCString(ctx, str);
+    js_free(ctx, str);
+    if (err < 0)
+        return JS_ThrowTypeError(ctx, "could not send response");
+    return JS_UNDEFINED;
+}
+
+/* Streamed responses. startResponse() sends the status and headers straight
+ * away and returns a writable stream for the body, so large pages can be
+ * flushed to the client while they are still being generated. */
+
+typedef struct {
+    bool finished;
+} JSLambdaResponseStream;
+
+static JSClassID js_lambda_response_stream_class_id;
+
+static void js_lambda_response_stream_finalizer(JSRuntime *rt, JSValue val) {
+    JSLambdaResponseStream *s =
+        JS_GetOpaque(val, js_lambda_response_stream_class_id);
+    if (s) {
+        if (!s->finished)
+            lambda_response_finish();
+        js_free_rt(rt, s);
+    }
+}
+
+static JSClassDef js_lambda_response_stream_class = {
+    "ResponseStream",
+    .finalizer = js_lambda_response_stream_finalizer,
+};
+
+static JSValue js_lambda_start_response(JSContext *ctx, JSValueConst this_val,
+                                        int argc, JSValueConst *argv) {
+    JSLambdaResponseStream *s;
+    JSValue obj;
+    char *str;
+    size_t len;
+    uint32_t status_code;
+    int err;
+
+    if (JS_ToUint32(ctx, &status_code, argv[0]))
+        return JS_EXCEPTION;
+
+    if (argc > 1 && !JS_IsUndefined(argv[1])) {
+        str = JS_JSONStringifyUTF8(ctx, &len, argv[1]);
+        if (!str)
+            return JS_EXCEPTION;
+        err = lambda_response_start(status_code, str, len);
+        js_free(ctx, str);
+    } else {
+        err = lambda_response_start(status_code, "{}", 2);
+    }
+    if (err < 0)
+        return JS_ThrowTypeError(ctx, "could not start response");
+
+    obj = JS_NewObjectClass(ctx, js_lambda_response_stream_class_id);
+    if (JS_IsException(obj))
+        return obj;
+    s = js_mallocz(ctx, sizeof(*s));
+    if (!s) {
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
+    JS_SetOpaque(obj, s);
+    return obj;
+}
+
+/* Accepts strings, ArrayBuffers and typed arrays. */
+static int js_lambda_response_write_chunk(JSContext *ctx, JSValueConst chunk) {
+    const uint8_t *buf;
+    size_t len, offset, size;
+    JSValue abuf;
+    int err;
+
+    if (JS_IsString(chunk)) {
+        const char *str = JS_ToCStringLen(ctx, &len, chunk);
+        if (!str)
+            return -1;
+        err = lambda_response_write(str, len);
+        JS_FreeCString(ctx, str);
+    } else {
+        abuf = JS_GetTypedArrayBuffer(ctx, chunk, &offset, &len, &size);
+        if (JS_IsException(abuf)) {
+            JS_FreeValue(ctx, JS_GetException(ctx));
+            offset = 0;
+            buf = JS_GetArrayBuffer(ctx, &len, chunk);
+        } else {
+            buf = JS_GetArrayBuffer(ctx, &size, abuf);
+            JS_FreeValue(ctx, abuf);
+        }
+        if (!buf)
+            return -1;
+        err = lambda_response_write((const char *)buf + offset, len);
+    }
+
+    if (err < 0) {
+        JS_ThrowTypeError(ctx, "response stream is closed");
+        return -1;
+    }
+    return 0;
+}
+
+static JSValue js_lambda_response_stream_write(JSContext *ctx,
+                                               JSValueConst this_val, int argc,
+                                               JSValueConst *argv, int magic) {
+    JSLambdaResponseStream *s =
+        JS_GetOpaque2(ctx, this_val, js_lambda_response_stream_class_id);
+    if (!s)
+        return JS_EXCEPTION;
+    if (s->finished)
+        return JS_ThrowTypeError(ctx, "response stream is closed");
+
+    if (argc > 0 && !JS_IsUndefined(argv[0]) &&
+        js_lambda_response_write_chunk(ctx, argv[0]) < 0)
+        return JS_EXCEPTION;
+
+    /* end() */
+    if (magic) {
+        s->finished = true;
+        lambda_response_finish();
+    }
     return JS_UNDEFINED;
 }
 
+static const JSCFunctionListEntry js_lambda_response_stream_proto_funcs[] = {
+    JS_CFUNC_MAGIC_DEF("write", 1, js_lambda_response_stream_write, 0),
+    JS_CFUNC_MAGIC_DEF("end", 1, js_lambda_response_stream_write, 1),
+};
+
 static const JSCFunctionListEntry js_lambda_funcs[] = {
     JS_CFUNC_DEF("nextEvent", 0, js_lambda_next_event),
     JS_CFUNC_DEF("sendResponse", 1, js_lambda_send_response),
+    JS_CFUNC_DEF("startResponse", 2, js_lambda_start_response),
 };
 
 static int js_lambda_init(JSContext *ctx, JSModuleDef *m) {
+    JSValue proto;
+
+    /* the class ID is created once */
+    JS_NewClassID(&js_lambda_event_class_id);
+    /* the class is created once per runtime */
+    JS_NewClass(JS_GetRuntime(ctx), js_lambda_event_class_id,
+                &js_lambda_event_class);
+    /* the fields are all own properties, see above */
+    JS_SetClassProto(ctx, js_lambda_event_class_id, JS_NewObject(ctx));
+
+    JS_NewClassID(&js_lambda_response_stream_class_id);
+    JS_NewClass(JS_GetRuntime(ctx), js_lambda_response_stream_class_id,
+                &js_lambda_response_stream_class);
+    proto = JS_NewObject(ctx);
+    JS_SetPropertyFunctionList(ctx, proto,
+                               js_lambda_response_stream_proto_funcs,
+                               countof(js_lambda_response_stream_proto_funcs));
+    JS_SetClassProto(ctx, js_lambda_response_stream_class_id, proto);
+
     return JS_SetModuleExportList(ctx, m, js_lambda_funcs,
                                   countof(js_lambda_funcs));
 }
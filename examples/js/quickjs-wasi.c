@@ -39,6 +39,7 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 
 #include "cutils.h"
 #include "list.h"
@@ -59,9 +60,10 @@ typedef struct {
 } JSOSSignalHandler;
 
 typedef struct {
-    struct list_head link;
+    int heap_index; /* index in JSThreadState.timers, -1 if not scheduled */
     BOOL has_object;
     int64_t timeout;
+    uint64_t seq; /* timers with the same timeout run in creation order */
     JSValue func;
 } JSOSTimer;
 
@@ -90,10 +92,15 @@ typedef struct {
 typedef struct JSThreadState {
     struct list_head os_rw_handlers; /* list of JSOSRWHandler.link */
     struct list_head os_signal_handlers; /* list JSOSSignalHandler.link */
-    struct list_head os_timers; /* list of JSOSTimer.link */
+    JSOSTimer **timers; /* binary min-heap ordered by timeout */
+    int timer_count;
+    int timer_size;
+    uint64_t timer_seq;
     struct list_head port_list; /* list of JSWorkerMessageHandler.link */
     /* not used in the main thread */
     JSWorkerMessagePipe *recv_pipe, *send_pipe;
+    uint8_t *bundle_buf; /* module bundle, NULL if none */
+    size_t bundle_len;
 } JSThreadState;
 
 static uint64_t os_pending_signals;
@@ -445,11 +452,284 @@ int js_module_set_import_meta(JSContext *ctx, JSValueConst func_val, JS_BOOL is_
     return 0;
 }
 
+/* Module bundles contain the bytecode of a module and of all the
+   modules it imports, so that the imports are resolved without
+   loading and compiling a file for each of them. The layout is:
+
+   - the magic "JSB1" and the number of modules,
+   - for each module, the offset of its zero terminated name and the
+     offset and length of its bytecode,
+   - the names and the bytecode.
+
+   The offsets are relative to the start of the bundle and all the
+   integers are 32 bit. The main module is the last one. */
+
+#define JS_BUNDLE_MAGIC "JSB1"
+#define JS_BUNDLE_HEADER_LEN 8
+#define JS_BUNDLE_ENTRY_LEN 12
+
+static uint32_t js_bundle_count(const uint8_t *buf)
+{
+    return get_u32(buf + 4);
+}
+
+static const uint8_t *js_bundle_entry(const uint8_t *buf, uint32_t idx)
+{
+    return buf + JS_BUNDLE_HEADER_LEN + idx * JS_BUNDLE_ENTRY_LEN;
+}
+
+static const char *js_bundle_name(const uint8_t *buf, uint32_t idx)
+{
+    return (const char *)buf + get_u32(js_bundle_entry(buf, idx));
+}
+
+/* Use 'buf' as the module bundle of the runtime, which then owns it.
+   Return -1 if 'buf' is not a valid bundle. */
+int js_std_set_bundle(JSContext *ctx, uint8_t *buf, size_t buf_len)
+{
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    JSThreadState *ts = JS_GetRuntimeOpaque(rt);
+    const uint8_t *e;
+    uint32_t count, i, name_offset, offset, len;
+
+    if (buf_len < JS_BUNDLE_HEADER_LEN ||
+        memcmp(buf, JS_BUNDLE_MAGIC, 4) != 0)
+        return -1;
+    count = js_bundle_count(buf);
+    if (count == 0 ||
+        count > (buf_len - JS_BUNDLE_HEADER_LEN) / JS_BUNDLE_ENTRY_LEN)
+        return -1;
+    for(i = 0; i < count; i++) {
+        e = js_bundle_entry(buf, i);
+        name_offset = get_u32(e);
+        offset = get_u32(e + 4);
+        len = get_u32(e + 8);
+        if (name_offset >= buf_len ||
+            !memchr(buf + name_offset, '\0', buf_len - name_offset) ||
+            offset > buf_len || len > buf_len - offset)
+            return -1;
+    }
+    if (ts->bundle_buf)
+        js_free_rt(rt, ts->bundle_buf);
+    ts->bundle_buf = buf;
+    ts->bundle_len = buf_len;
+    return 0;
+}
+
+/* Return the module 'idx' of the bundle, not yet resolved */
+static JSValue js_bundle_read_module(JSContext *ctx, JSThreadState *ts,
+                                     uint32_t idx)
+{
+    const uint8_t *e;
+    JSValue obj;
+
+    e = js_bundle_entry(ts->bundle_buf, idx);
+    obj = JS_ReadObject(ctx, ts->bundle_buf + get_u32(e + 4), get_u32(e + 8),
+                        JS_READ_OBJ_BYTECODE);
+    if (JS_IsException(obj))
+        return obj;
+    if (JS_VALUE_GET_TAG(obj) != JS_TAG_MODULE) {
+        JS_FreeValue(ctx, obj);
+        return JS_ThrowTypeError(ctx, "module '%s' of the bundle is invalid",
+                                 js_bundle_name(ts->bundle_buf, idx));
+    }
+    return obj;
+}
+
+/* evaluate the main module of the bundle */
+JSValue js_std_eval_bundle(JSContext *ctx)
+{
+    JSThreadState *ts = JS_GetRuntimeOpaque(JS_GetRuntime(ctx));
+    JSValue obj;
+
+    if (!ts->bundle_buf)
+        return JS_ThrowReferenceError(ctx, "no module bundle");
+    obj = js_bundle_read_module(ctx, ts,
+                                js_bundle_count(ts->bundle_buf) - 1);
+    if (JS_IsException(obj))
+        return obj;
+    if (JS_ResolveModule(ctx, obj) < 0) {
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
+    js_module_set_import_meta(ctx, obj, TRUE);
+    return JS_EvalFunction(ctx, obj);
+}
+
+/* Return FALSE if the bundle does not contain the module
+   'module_name'. Otherwise set '*pm' to the module, or to NULL in case
+   of exception. */
+static BOOL js_bundle_load_module(JSContext *ctx, JSModuleDef **pm,
+                                  const char *module_name)
+{
+    JSThreadState *ts = JS_GetRuntimeOpaque(JS_GetRuntime(ctx));
+    JSValue func_val;
+    uint32_t i, count;
+
+    if (!ts->bundle_buf)
+        return FALSE;
+    count = js_bundle_count(ts->bundle_buf);
+    for(i = 0; i < count; i++) {
+        if (!strcmp(js_bundle_name(ts->bundle_buf, i), module_name))
+            break;
+    }
+    if (i == count)
+        return FALSE;
+    *pm = NULL;
+    func_val = js_bundle_read_module(ctx, ts, i);
+    if (JS_IsException(func_val))
+        return TRUE;
+    js_module_set_import_meta(ctx, func_val, FALSE);
+    /* the module is already referenced, so we must free it */
+    *pm = JS_VALUE_GET_PTR(func_val);
+    JS_FreeValue(ctx, func_val);
+    return TRUE;
+}
+
+typedef struct {
+    DynBuf entries; /* offsets relative to 'names' and 'bytecode' */
+    DynBuf names;
+    DynBuf bytecode;
+} JSBundleWriter;
+
+static int js_bundle_add(JSContext *ctx, JSBundleWriter *w,
+                         const char *module_name, JSValueConst func_val)
+{
+    uint8_t *buf;
+    size_t buf_len;
+
+    buf = JS_WriteObject(ctx, &buf_len, func_val, JS_WRITE_OBJ_BYTECODE);
+    if (!buf)
+        return -1;
+    dbuf_put_u32(&w->entries, w->names.size);
+    dbuf_put_u32(&w->entries, w->bytecode.size);
+    dbuf_put_u32(&w->entries, buf_len);
+    dbuf_put(&w->names, (const uint8_t *)module_name, strlen(module_name) + 1);
+    dbuf_put(&w->bytecode, buf, buf_len);
+    js_free(ctx, buf);
+    if (dbuf_error(&w->entries) || dbuf_error(&w->names) ||
+        dbuf_error(&w->bytecode)) {
+        JS_ThrowOutOfMemory(ctx);
+        return -1;
+    }
+    return 0;
+}
+
+/* compile the imported modules and add them to the bundle */
+static JSModuleDef *js_bundle_writer_loader(JSContext *ctx,
+                                            const char *module_name,
+                                            void *opaque)
+{
+    JSBundleWriter *w = opaque;
+    JSModuleDef *m;
+    JSValue func_val;
+    uint8_t *buf;
+    size_t buf_len;
+
+    buf = js_load_file(ctx, &buf_len, module_name);
+    if (!buf) {
+        JS_ThrowReferenceError(ctx, "could not load module filename '%s'",
+                               module_name);
+        return NULL;
+    }
+    /* the imports of the module are added before it */
+    func_val = JS_Eval(ctx, (char *)buf, buf_len, module_name,
+                       JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    js_free(ctx, buf);
+    if (JS_IsException(func_val))
+        return NULL;
+    if (js_bundle_add(ctx, w, module_name, func_val)) {
+        JS_FreeValue(ctx, func_val);
+        return NULL;
+    }
+    /* the module is already referenced, so we must free it */
+    m = JS_VALUE_GET_PTR(func_val);
+    JS_FreeValue(ctx, func_val);
+    return m;
+}
+
+/* Write to 'bundle_filename' the bundle of the module 'filename' and of
+   the modules it imports. Return -1 with an exception if error. */
+int js_std_write_bundle(JSContext *ctx, const char *bundle_filename,
+                        const char *filename)
+{
+    JSRuntime *rt = JS_GetRuntime(ctx);
+    JSBundleWriter w_s, *w = &w_s;
+    JSValue func_val;
+    DynBuf out;
+    uint8_t *buf;
+    size_t buf_len, base;
+    uint32_t count, i;
+    FILE *f;
+    int ret;
+
+    js_std_dbuf_init(ctx, &w->entries);
+    js_std_dbuf_init(ctx, &w->names);
+    js_std_dbuf_init(ctx, &w->bytecode);
+    js_std_dbuf_init(ctx, &out);
+    ret = -1;
+
+    JS_SetModuleLoaderFunc(rt, NULL, js_bundle_writer_loader, w);
+    buf = js_load_file(ctx, &buf_len, filename);
+    if (!buf) {
+        JS_ThrowReferenceError(ctx, "could not load '%s'", filename);
+        goto done;
+    }
+    func_val = JS_Eval(ctx, (char *)buf, buf_len, filename,
+                       JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+    js_free(ctx, buf);
+    if (JS_IsException(func_val))
+        goto done;
+    if (js_bundle_add(ctx, w, filename, func_val)) {
+        JS_FreeValue(ctx, func_val);
+        goto done;
+    }
+    JS_FreeValue(ctx, func_val);
+
+    /* relocate the offsets */
+    count = w->entries.size / JS_BUNDLE_ENTRY_LEN;
+    base = JS_BUNDLE_HEADER_LEN + w->entries.size;
+    for(i = 0; i < count; i++) {
+        buf = w->entries.buf + i * JS_BUNDLE_ENTRY_LEN;
+        put_u32(buf, get_u32(buf) + base);
+        put_u32(buf + 4, get_u32(buf + 4) + base + w->names.size);
+    }
+    dbuf_put(&out, (const uint8_t *)JS_BUNDLE_MAGIC, 4);
+    dbuf_put_u32(&out, count);
+    dbuf_put(&out, w->entries.buf, w->entries.size);
+    dbuf_put(&out, w->names.buf, w->names.size);
+    dbuf_put(&out, w->bytecode.buf, w->bytecode.size);
+    if (dbuf_error(&out)) {
+        JS_ThrowOutOfMemory(ctx);
+        goto done;
+    }
+
+    f = fopen(bundle_filename, "wb");
+    if (f) {
+        if (fwrite(out.buf, 1, out.size, f) == out.size)
+            ret = 0;
+        if (fclose(f) != 0)
+            ret = -1;
+    }
+    if (ret < 0)
+        JS_ThrowReferenceError(ctx, "could not write '%s'", bundle_filename);
+ done:
+    JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    dbuf_free(&w->entries);
+    dbuf_free(&w->names);
+    dbuf_free(&w->bytecode);
+    dbuf_free(&out);
+    return ret;
+}
+
 JSModuleDef *js_module_loader(JSContext *ctx,
                               const char *module_name, void *opaque)
 {
     JSModuleDef *m;
 
+    if (js_bundle_load_module(ctx, &m, module_name))
+        return m;
+
     /* if (has_suffix(module_name, ".so")) {
         m = js_module_loader_so(ctx, module_name);
     } else */ {
@@ -1428,11 +1708,89 @@ static int64_t get_time_ms(void)
     return (uint64_t)ts.tv_sec * 1000 + (ts.tv_nsec / 1000000);
 }
 
+static BOOL timer_before(const JSOSTimer *a, const JSOSTimer *b)
+{
+    if (a->timeout != b->timeout)
+        return a->timeout < b->timeout;
+    return a->seq < b->seq;
+}
+
+static void timer_heap_set(JSThreadState *ts, int i, JSOSTimer *th)
+{
+    ts->timers[i] = th;
+    th->heap_index = i;
+}
+
+static void timer_heap_up(JSThreadState *ts, int i)
+{
+    JSOSTimer *th = ts->timers[i];
+    int parent;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!timer_before(th, ts->timers[parent]))
+            break;
+        timer_heap_set(ts, i, ts->timers[parent]);
+        i = parent;
+    }
+    timer_heap_set(ts, i, th);
+}
+
+static void timer_heap_down(JSThreadState *ts, int i)
+{
+    JSOSTimer *th = ts->timers[i];
+    int child;
+
+    for(;;) {
+        child = 2 * i + 1;
+        if (child >= ts->timer_count)
+            break;
+        if (child + 1 < ts->timer_count &&
+            timer_before(ts->timers[child + 1], ts->timers[child]))
+            child++;
+        if (!timer_before(ts->timers[child], th))
+            break;
+        timer_heap_set(ts, i, ts->timers[child]);
+        i = child;
+    }
+    timer_heap_set(ts, i, th);
+}
+
+static int add_timer(JSContext *ctx, JSThreadState *ts, JSOSTimer *th)
+{
+    JSOSTimer **new_timers;
+    int new_size;
+
+    if (ts->timer_count >= ts->timer_size) {
+        new_size = max_int(16, ts->timer_size * 3 / 2);
+        new_timers = js_realloc(ctx, ts->timers,
+                                sizeof(ts->timers[0]) * new_size);
+        if (!new_timers)
+            return -1;
+        ts->timers = new_timers;
+        ts->timer_size = new_size;
+    }
+    th->seq = ts->timer_seq++;
+    timer_heap_set(ts, ts->timer_count++, th);
+    timer_heap_up(ts, th->heap_index);
+    return 0;
+}
+
 static void unlink_timer(JSRuntime *rt, JSOSTimer *th)
 {
-    if (th->link.prev) {
-        list_del(&th->link);
-        th->link.prev = th->link.next = NULL;
+    JSThreadState *ts = JS_GetRuntimeOpaque(rt);
+    JSOSTimer *last;
+    int i;
+
+    i = th->heap_index;
+    if (i < 0)
+        return;
+    th->heap_index = -1;
+    last = ts->timers[--ts->timer_count];
+    if (last != th) {
+        timer_heap_set(ts, i, last);
+        timer_heap_up(ts, i);
+        timer_heap_down(ts, last->heap_index);
     }
 }
 
@@ -1449,7 +1807,7 @@ static void js_os_timer_finalizer(JSRuntime *rt, JSValue val)
     JSOSTimer *th = JS_GetOpaque(val, js_os_timer_class_id);
     if (th) {
         th->has_object = FALSE;
-        if (!th->link.prev)
+        if (th->heap_index < 0)
             free_timer(rt, th);
     }
 }
@@ -1489,7 +1847,11 @@ static JSValue js_os_setTimeout(JSContext *ctx, JSValueConst this_val,
     th->has_object = TRUE;
     th->timeout = get_time_ms() + delay;
     th->func = JS_DupValue(ctx, func);
-    list_add_tail(&th->link, &ts->os_timers);
+    if (add_timer(ctx, ts, th)) {
+        free_timer(rt, th);
+        JS_FreeValue(ctx, obj);
+        return JS_EXCEPTION;
+    }
     JS_SetOpaque(obj, th);
     return obj;
 }
@@ -1529,16 +1891,21 @@ static int handle_posted_message(JSRuntime *rt, JSContext *ctx,
     return 0;
 }
 
+/* Number of file descriptors which can be polled without allocating */
+#define POLL_FDS_STATIC 16
+
+/* Runs at most one handler. The closest timer and all the file
+   descriptors are waited for with a single poll(), which WASI
+   implements with one poll_oneoff() call. */
 static int js_os_poll(JSContext *ctx)
 {
     JSRuntime *rt = JS_GetRuntime(ctx);
     JSThreadState *ts = JS_GetRuntimeOpaque(rt);
-    int ret, fd_max, min_delay;
-    int64_t cur_time, delay;
-    fd_set rfds, wfds;
+    int ret, nfds, i, timeout;
+    int64_t delay;
+    struct pollfd pfds_static[POLL_FDS_STATIC], *pfds, *pfd;
     JSOSRWHandler *rh;
     struct list_head *el;
-    struct timeval tv, *tvp;
 
     /* only check signals in the main thread */
     if (!ts->recv_pipe &&
@@ -1557,71 +1924,84 @@ static int js_os_poll(JSContext *ctx)
         }
     }
 
-    if (list_empty(&ts->os_rw_handlers) && list_empty(&ts->os_timers) &&
+    if (list_empty(&ts->os_rw_handlers) && ts->timer_count == 0 &&
         list_empty(&ts->port_list))
         return -1; /* no more events */
 
-    if (!list_empty(&ts->os_timers)) {
-        cur_time = get_time_ms();
-        min_delay = 10000;
-        list_for_each(el, &ts->os_timers) {
-            JSOSTimer *th = list_entry(el, JSOSTimer, link);
-            delay = th->timeout - cur_time;
-            if (delay <= 0) {
-                JSValue func;
-                /* the timer expired */
-                func = th->func;
-                th->func = JS_UNDEFINED;
-                unlink_timer(rt, th);
-                if (!th->has_object)
-                    free_timer(rt, th);
-                call_handler(ctx, func);
-                JS_FreeValue(ctx, func);
-                return 0;
-            } else if (delay < min_delay) {
-                min_delay = delay;
-            }
+    if (ts->timer_count > 0) {
+        JSOSTimer *th = ts->timers[0];
+        delay = th->timeout - get_time_ms();
+        if (delay <= 0) {
+            JSValue func;
+            /* the timer expired */
+            func = th->func;
+            th->func = JS_UNDEFINED;
+            unlink_timer(rt, th);
+            if (!th->has_object)
+                free_timer(rt, th);
+            call_handler(ctx, func);
+            JS_FreeValue(ctx, func);
+            return 0;
         }
-        tv.tv_sec = min_delay / 1000;
-        tv.tv_usec = (min_delay % 1000) * 1000;
-        tvp = &tv;
+        timeout = min_int64(delay, INT32_MAX);
     } else {
-        tvp = NULL;
+        timeout = -1;
     }
 
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-    fd_max = -1;
+    nfds = 0;
+    list_for_each(el, &ts->os_rw_handlers) {
+        nfds++;
+    }
+    list_for_each(el, &ts->port_list) {
+        nfds++;
+    }
+    if (nfds <= POLL_FDS_STATIC) {
+        pfds = pfds_static;
+    } else {
+        pfds = js_malloc(ctx, sizeof(pfds[0]) * nfds);
+        if (!pfds) {
+            js_std_dump_error(ctx);
+            return -1;
+        }
+    }
+
+    pfd = pfds;
     list_for_each(el, &ts->os_rw_handlers) {
         rh = list_entry(el, JSOSRWHandler, link);
-        fd_max = max_int(fd_max, rh->fd);
+        pfd->fd = rh->fd;
+        pfd->events = 0;
         if (!JS_IsNull(rh->rw_func[0]))
-            FD_SET(rh->fd, &rfds);
+            pfd->events |= POLLIN;
         if (!JS_IsNull(rh->rw_func[1]))
-            FD_SET(rh->fd, &wfds);
+            pfd->events |= POLLOUT;
+        pfd->revents = 0;
+        pfd++;
     }
 
     list_for_each(el, &ts->port_list) {
         JSWorkerMessageHandler *port = list_entry(el, JSWorkerMessageHandler, link);
-        if (!JS_IsNull(port->on_message_func)) {
-            JSWorkerMessagePipe *ps = port->recv_pipe;
-            fd_max = max_int(fd_max, ps->read_fd);
-            FD_SET(ps->read_fd, &rfds);
-        }
+        /* a negative descriptor is ignored */
+        pfd->fd = JS_IsNull(port->on_message_func) ? -1 : port->recv_pipe->read_fd;
+        pfd->events = POLLIN;
+        pfd->revents = 0;
+        pfd++;
     }
 
-    ret = select(fd_max + 1, &rfds, &wfds, NULL, tvp);
+    ret = poll(pfds, nfds, timeout);
     if (ret > 0) {
+        /* the handlers are in the same order as the descriptors */
+        i = 0;
         list_for_each(el, &ts->os_rw_handlers) {
             rh = list_entry(el, JSOSRWHandler, link);
+            pfd = &pfds[i++];
             if (!JS_IsNull(rh->rw_func[0]) &&
-                FD_ISSET(rh->fd, &rfds)) {
+                (pfd->revents & (POLLIN | POLLHUP | POLLERR))) {
                 call_handler(ctx, rh->rw_func[0]);
                 /* must stop because the list may have been modified */
                 goto done;
             }
             if (!JS_IsNull(rh->rw_func[1]) &&
-                FD_ISSET(rh->fd, &wfds)) {
+                (pfd->revents & (POLLOUT | POLLERR))) {
                 call_handler(ctx, rh->rw_func[1]);
                 /* must stop because the list may have been modified */
                 goto done;
@@ -1630,16 +2010,16 @@ static int js_os_poll(JSContext *ctx)
 
         list_for_each(el, &ts->port_list) {
             JSWorkerMessageHandler *port = list_entry(el, JSWorkerMessageHandler, link);
-            if (!JS_IsNull(port->on_message_func)) {
-                JSWorkerMessagePipe *ps = port->recv_pipe;
-                if (FD_ISSET(ps->read_fd, &rfds)) {
-                    if (handle_posted_message(rt, ctx, port))
-                        goto done;
-                }
+            pfd = &pfds[i++];
+            if (pfd->fd >= 0 && (pfd->revents & POLLIN)) {
+                if (handle_posted_message(rt, ctx, port))
+                    goto done;
             }
         }
     }
     done:
+    if (pfds != pfds_static)
+        js_free(ctx, pfds);
     return 0;
 }
 
@@ -2095,7 +2475,6 @@ void js_std_init_handlers(JSRuntime *rt)
     memset(ts, 0, sizeof(*ts));
     init_list_head(&ts->os_rw_handlers);
     init_list_head(&ts->os_signal_handlers);
-    init_list_head(&ts->os_timers);
     init_list_head(&ts->port_list);
 
     JS_SetRuntimeOpaque(rt, ts);
@@ -2116,12 +2495,16 @@ void js_std_free_handlers(JSRuntime *rt)
         free_sh(rt, sh);
     }
 
-    list_for_each_safe(el, el1, &ts->os_timers) {
-        JSOSTimer *th = list_entry(el, JSOSTimer, link);
+    while (ts->timer_count > 0) {
+        JSOSTimer *th = ts->timers[0];
         unlink_timer(rt, th);
         if (!th->has_object)
             free_timer(rt, th);
     }
+    js_free_rt(rt, ts->timers);
+
+    if (ts->bundle_buf)
+        js_free_rt(rt, ts->bundle_buf);
 
     free(ts);
     JS_SetRuntimeOpaque(rt, NULL); /* fail safe */
@@ -2165,6 +2548,21 @@ void js_std_dump_error(JSContext *ctx)
     JS_FreeValue(ctx, exception_val);
 }
 
+/* print the GC statistics on a single line so that the host can log
+   them with the request */
+void js_std_dump_gc_stats(JSRuntime *rt, FILE *f)
+{
+    JSGCStats st;
+
+    JS_GetGCStats(rt, &st);
+    fprintf(f, "gc: count=%" PRId64 " minor=%" PRId64 " pause_us=%" PRId64
+            " scanned=%" PRId64 " freed=%" PRId64 " bytes_freed=%" PRId64
+            " threshold=%" PRId64 "\n",
+            st.gc_count, st.minor_gc_count, st.pause_time,
+            st.objects_scanned, st.objects_freed, st.bytes_freed,
+            st.threshold);
+}
+
 void js_std_promise_rejection_tracker(JSContext *ctx, JSValueConst promise,
                                       JSValueConst reason,
                                       BOOL is_handled, void *opaque)
@@ -2178,13 +2576,15 @@ void js_std_promise_rejection_tracker(JSContext *ctx, JSValueConst promise,
 /* main loop which calls the user JS callbacks */
 void js_std_loop(JSContext *ctx)
 {
+    JSRuntime *rt = JS_GetRuntime(ctx);
     JSContext *ctx1;
-    int err;
+    int err, slice_time;
 
+    slice_time = JS_GetGCSliceTime(rt);
     for(;;) {
         /* execute the pending jobs */
         for(;;) {
-            err = JS_ExecutePendingJob(JS_GetRuntime(ctx), &ctx1);
+            err = JS_ExecutePendingJob(rt, &ctx1);
             if (err <= 0) {
                 if (err < 0) {
                     js_std_dump_error(ctx1);
@@ -2193,6 +2593,10 @@ void js_std_loop(JSContext *ctx)
             }
         }
 
+        /* collect a GC slice while waiting for the next event */
+        if (slice_time > 0)
+            JS_RunGCSlice(rt, slice_time);
+
         if (!os_poll_func || os_poll_func(ctx))
             break;
     }
@@ -40,10 +40,15 @@ void js_std_loop(JSContext *ctx);
 void js_std_init_handlers(JSRuntime *rt);
 void js_std_free_handlers(JSRuntime *rt);
 void js_std_dump_error(JSContext *ctx);
+void js_std_dump_gc_stats(JSRuntime *rt, FILE *f);
 uint8_t *js_load_file(JSContext *ctx, size_t *pbuf_len, const char *filename);
 int js_module_set_import_meta(JSContext *ctx, JSValueConst func_val, JS_BOOL is_main);
 JSModuleDef *js_module_loader(JSContext *ctx,
                               const char *module_name, void *opaque);
+int js_std_set_bundle(JSContext *ctx, uint8_t *buf, size_t buf_len);
+JSValue js_std_eval_bundle(JSContext *ctx);
+int js_std_write_bundle(JSContext *ctx, const char *bundle_filename,
+                        const char *filename);
 void js_std_eval_binary(JSContext *ctx, const uint8_t *buf, size_t buf_len,
                         int flags);
 void js_std_promise_rejection_tracker(JSContext *ctx, JSValueConst promise,
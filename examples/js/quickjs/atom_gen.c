@@ -0,0 +1,71 @@
+/*
+ * Generation of the hash values of the predefined atoms
+ *
+ * Usage: atom_gen [output_file]
+ *
+ * Writes a JS_ATOM_INIT_HASH_<name> define for each atom of
+ * quickjs-atom.h so that JS_InitAtoms() does not hash them when a
+ * runtime is created. The output is quickjs-atom-hash.h.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+/* list the atoms of every configuration */
+#ifndef CONFIG_BIGNUM
+#define CONFIG_BIGNUM
+#endif
+#ifndef CONFIG_ATOMICS
+#define CONFIG_ATOMICS
+#endif
+
+typedef struct {
+    const char *name;
+    const char *str;
+    size_t len;
+} AtomDef;
+
+static const AtomDef atom_defs[] = {
+#define DEF(name, str) { #name, str, sizeof(str) - 1 },
+#include "quickjs-atom.h"
+#undef DEF
+};
+
+/* must match hash_string8() in quickjs.c for a JS_ATOM_TYPE_STRING
+   atom, masked with JS_ATOM_HASH_MASK */
+static uint32_t hash_atom(const char *str, size_t len)
+{
+    uint32_t h;
+    size_t i;
+
+    h = 1; /* JS_ATOM_TYPE_STRING */
+    for(i = 0; i < len; i++)
+        h = h * 263 + (uint8_t)str[i];
+    return h & ((1 << 29) - 1);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    size_t i;
+
+    if (argc >= 2) {
+        f = fopen(argv[1], "wb");
+        if (!f) {
+            perror(argv[1]);
+            exit(1);
+        }
+    } else {
+        f = stdout;
+    }
+    fprintf(f, "/* Hash values of the predefined atoms */\n"
+            "/* Automatically generated file - do not edit */\n\n");
+    for(i = 0; i < sizeof(atom_defs) / sizeof(atom_defs[0]); i++) {
+        const AtomDef *d = &atom_defs[i];
+        fprintf(f, "#define JS_ATOM_INIT_HASH_%s 0x%08" PRIx32 "\n",
+                d->name, hash_atom(d->str, d->len));
+    }
+    if (f != stdout)
+        fclose(f);
+    return 0;
+}
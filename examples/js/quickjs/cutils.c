@@ -303,6 +303,204 @@ int unicode_from_utf8(const uint8_t *p, int max_len, const uint8_t **pp)
     return c;
 }
 
+/* String scanning kernels. Each function returns the index of the
+   first matching element or 'len' if there is none. With CONFIG_SIMD
+   they are vectorized with AVX2, SSE2 or wasm simd128, whichever the
+   compiler targets. */
+
+#if defined(CONFIG_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i vec_t;
+#define VEC_SIZE 32
+#define vec_load(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define vec_splat8(c)      _mm256_set1_epi8(c)
+#define vec_splat16(c)     _mm256_set1_epi16(c)
+#define vec_eq8(a, b)      _mm256_cmpeq_epi8(a, b)
+#define vec_eq16(a, b)     _mm256_cmpeq_epi16(a, b)
+#define vec_min8(a, b)     _mm256_min_epu8(a, b)
+#define vec_and(a, b)      _mm256_and_si256(a, b)
+#define vec_or(a, b)       _mm256_or_si256(a, b)
+#define vec_mask(a)        ((uint32_t)_mm256_movemask_epi8(a))
+#elif defined(CONFIG_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i vec_t;
+#define VEC_SIZE 16
+#define vec_load(p)        _mm_loadu_si128((const __m128i *)(p))
+#define vec_splat8(c)      _mm_set1_epi8(c)
+#define vec_splat16(c)     _mm_set1_epi16(c)
+#define vec_eq8(a, b)      _mm_cmpeq_epi8(a, b)
+#define vec_eq16(a, b)     _mm_cmpeq_epi16(a, b)
+#define vec_min8(a, b)     _mm_min_epu8(a, b)
+#define vec_and(a, b)      _mm_and_si128(a, b)
+#define vec_or(a, b)       _mm_or_si128(a, b)
+#define vec_mask(a)        ((uint32_t)_mm_movemask_epi8(a))
+#elif defined(CONFIG_SIMD) && defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+typedef v128_t vec_t;
+#define VEC_SIZE 16
+#define vec_load(p)        wasm_v128_load(p)
+#define vec_splat8(c)      wasm_i8x16_splat(c)
+#define vec_splat16(c)     wasm_i16x8_splat(c)
+#define vec_eq8(a, b)      wasm_i8x16_eq(a, b)
+#define vec_eq16(a, b)     wasm_i16x8_eq(a, b)
+#define vec_min8(a, b)     wasm_u8x16_min(a, b)
+#define vec_and(a, b)      wasm_v128_and(a, b)
+#define vec_or(a, b)       wasm_v128_or(a, b)
+#define vec_mask(a)        ((uint32_t)wasm_i8x16_bitmask(a))
+#endif
+
+/* vec_mask() returns one bit per byte, so a 16 bit lane owns two
+   adjacent bits and the element index is the bit index divided by 2 */
+#define VEC_ALL_ONES       ((uint32_t)(((uint64_t)1 << VEC_SIZE) - 1))
+
+size_t str8_find_char(const uint8_t *p, size_t len, uint8_t c)
+{
+    /* the native libc memchr() is already vectorized */
+#if defined(VEC_SIZE) && defined(__wasm_simd128__)
+    size_t i;
+    vec_t vc = vec_splat8(c);
+    uint32_t m;
+
+    for(i = 0; i + VEC_SIZE <= len; i += VEC_SIZE) {
+        m = vec_mask(vec_eq8(vec_load(p + i), vc));
+        if (m)
+            return i + ctz32(m);
+    }
+    for(; i < len; i++) {
+        if (p[i] == c)
+            return i;
+    }
+    return len;
+#else
+    const uint8_t *q = memchr(p, c, len);
+    return q ? q - p : len;
+#endif
+}
+
+size_t str16_find_char(const uint16_t *p, size_t len, uint16_t c)
+{
+    size_t i = 0;
+#ifdef VEC_SIZE
+    vec_t vc = vec_splat16(c);
+    uint32_t m;
+
+    for(; i + VEC_SIZE / 2 <= len; i += VEC_SIZE / 2) {
+        m = vec_mask(vec_eq16(vec_load(p + i), vc));
+        if (m)
+            return i + ctz32(m) / 2;
+    }
+#endif
+    for(; i < len; i++) {
+        if (p[i] == c)
+            return i;
+    }
+    return len;
+}
+
+size_t str8_find_non_ascii(const uint8_t *p, size_t len)
+{
+    size_t i = 0;
+#ifdef VEC_SIZE
+    uint32_t m;
+
+    for(; i + VEC_SIZE <= len; i += VEC_SIZE) {
+        /* the mask is made of the byte sign bits */
+        m = vec_mask(vec_load(p + i));
+        if (m)
+            return i + ctz32(m);
+    }
+#endif
+    for(; i < len; i++) {
+        if (p[i] >= 0x80)
+            return i;
+    }
+    return len;
+}
+
+/* characters which must be escaped in a JSON string: control
+   characters, '"' and '\\' */
+size_t str8_find_json_special(const uint8_t *p, size_t len)
+{
+    size_t i = 0;
+    uint8_t c;
+#ifdef VEC_SIZE
+    vec_t quote = vec_splat8('\"');
+    vec_t backslash = vec_splat8('\\');
+    vec_t ctrl = vec_splat8(0x1f);
+    vec_t v;
+    uint32_t m;
+
+    for(; i + VEC_SIZE <= len; i += VEC_SIZE) {
+        v = vec_load(p + i);
+        m = vec_mask(vec_or(vec_or(vec_eq8(v, quote), vec_eq8(v, backslash)),
+                            vec_eq8(vec_min8(v, ctrl), v)));
+        if (m)
+            return i + ctz32(m);
+    }
+#endif
+    for(; i < len; i++) {
+        c = p[i];
+        if (c < 0x20 || c == '\"' || c == '\\')
+            return i;
+    }
+    return len;
+}
+
+/* same as str8_find_json_special() but also stops on surrogates so
+   that the caller can check the pairing */
+size_t str16_find_json_special(const uint16_t *p, size_t len)
+{
+    size_t i = 0;
+    uint16_t c;
+#ifdef VEC_SIZE
+    vec_t quote = vec_splat16('\"');
+    vec_t backslash = vec_splat16('\\');
+    vec_t ctrl_mask = vec_splat16(0xffe0);
+    vec_t surrogate_mask = vec_splat16(0xf800);
+    vec_t surrogate = vec_splat16(0xd800);
+    vec_t zero = vec_splat16(0);
+    vec_t v;
+    uint32_t m;
+
+    for(; i + VEC_SIZE / 2 <= len; i += VEC_SIZE / 2) {
+        v = vec_load(p + i);
+        m = vec_mask(vec_or(vec_or(vec_eq16(v, quote),
+                                   vec_eq16(v, backslash)),
+                            vec_or(vec_eq16(vec_and(v, ctrl_mask), zero),
+                                   vec_eq16(vec_and(v, surrogate_mask),
+                                            surrogate))));
+        if (m)
+            return i + ctz32(m) / 2;
+    }
+#endif
+    for(; i < len; i++) {
+        c = p[i];
+        if (c < 0x20 || c == '\"' || c == '\\' || (c & 0xf800) == 0xd800)
+            return i;
+    }
+    return len;
+}
+
+/* return the index of the first differing element */
+size_t str16_mismatch(const uint16_t *a, const uint16_t *b, size_t len)
+{
+    size_t i = 0;
+#ifdef VEC_SIZE
+    uint32_t m;
+
+    for(; i + VEC_SIZE / 2 <= len; i += VEC_SIZE / 2) {
+        m = vec_mask(vec_eq16(vec_load(a + i), vec_load(b + i)));
+        if (m != VEC_ALL_ONES)
+            return i + ctz32(~m) / 2;
+    }
+#endif
+    for(; i < len; i++) {
+        if (a[i] != b[i])
+            return i;
+    }
+    return len;
+}
+
 #if 0
 
 #if defined(EMSCRIPTEN) || defined(__ANDROID__)
@@ -278,6 +278,13 @@ static inline void dbuf_set_error(DynBuf *s)
 int unicode_to_utf8(uint8_t *buf, unsigned int c);
 int unicode_from_utf8(const uint8_t *p, int max_len, const uint8_t **pp);
 
+size_t str8_find_char(const uint8_t *p, size_t len, uint8_t c);
+size_t str16_find_char(const uint16_t *p, size_t len, uint16_t c);
+size_t str8_find_non_ascii(const uint8_t *p, size_t len);
+size_t str8_find_json_special(const uint8_t *p, size_t len);
+size_t str16_find_json_special(const uint16_t *p, size_t len);
+size_t str16_mismatch(const uint16_t *a, const uint16_t *b, size_t len);
+
 static inline int from_hex(int c)
 {
     if (c >= '0' && c <= '9')
@@ -54,5 +54,7 @@ DEF(bne_char_pos, 5) /* pop one stack element and jump if equal to the character
  position */
 DEF(prev, 1) /* go to the previous char */
 DEF(simple_greedy_quant, 17)
+DEF(first_chars, 35) /* filter of the match start positions, only at the
+                        start of the bytecode */
 
 #endif /* DEF */
@@ -106,6 +106,16 @@ static const REOpCode reopcode_info[REOP_COUNT] = {
 
 #define RE_HEADER_LEN 7
 
+/* REOP_first_chars flags */
+#define RE_FIRST_HIGH     (1 << 0) /* characters >= 256 can start a match */
+#define RE_FIRST_SINGLE   (1 << 1) /* single character < 256 */
+#define RE_FIRST_ANCHORED (1 << 2) /* match only at the start of the input */
+
+/* offsets of the REOP_first_chars operands */
+#define RE_FIRST_FLAGS  0
+#define RE_FIRST_CHAR   1 /* character if RE_FIRST_SINGLE */
+#define RE_FIRST_BITMAP 2 /* bitmap of the characters < 256 */
+
 static inline int is_digit(int c) {
     return c >= '0' && c <= '9';
 }
@@ -382,6 +392,9 @@ static __maybe_unused void lre_dump_bytecode(const uint8_t *buf,
                 }
             }
             break;
+        case REOP_first_chars:
+            printf(" flags=0x%x", buf[pos + 1 + RE_FIRST_FLAGS]);
+            break;
         default:
             break;
         }
@@ -1814,6 +1827,199 @@ static int compute_stack_size(const uint8_t *bc_buf, int bc_buf_len)
     return stack_size_max;
 }
 
+typedef struct {
+    uint8_t bitmap[32]; /* characters < 256 */
+    BOOL high; /* characters >= 256 */
+    int budget; /* number of opcodes which can still be examined */
+    BOOL ignore_case;
+    BOOL is_utf16;
+} REFirstChars;
+
+#define RE_FIRST_BUDGET 1000
+
+static void re_first_add(REFirstChars *fc, uint32_t c)
+{
+    fc->bitmap[c >> 3] |= 1 << (c & 7);
+}
+
+static void re_first_add_char(REFirstChars *fc, uint32_t val)
+{
+    uint32_t c;
+    if (fc->ignore_case) {
+        /* the characters >= 256 can also be canonicalized to 'val' */
+        for(c = 0; c < 256; c++) {
+            if (lre_canonicalize(c, fc->is_utf16) == val)
+                re_first_add(fc, c);
+        }
+        fc->high = TRUE;
+    } else if (val < 256) {
+        re_first_add(fc, val);
+    } else {
+        fc->high = TRUE;
+    }
+}
+
+static void re_first_add_range(REFirstChars *fc, const uint8_t *pc,
+                               BOOL is_range32)
+{
+    uint32_t c, c1, low, high;
+    int n, i, elt_size;
+
+    n = get_u16(pc);
+    pc += 2;
+    elt_size = is_range32 ? 8 : 4;
+    for(c = 0; c < 256; c++) {
+        c1 = c;
+        if (fc->ignore_case)
+            c1 = lre_canonicalize(c, fc->is_utf16);
+        for(i = 0; i < n; i++) {
+            if (is_range32) {
+                low = get_u32(pc + i * elt_size);
+                high = get_u32(pc + i * elt_size + 4);
+            } else {
+                low = get_u16(pc + i * elt_size);
+                high = get_u16(pc + i * elt_size + 2);
+            }
+            if (c1 >= low && c1 <= high) {
+                re_first_add(fc, c);
+                break;
+            }
+        }
+    }
+    if (is_range32)
+        high = get_u32(pc + (n - 1) * elt_size + 4);
+    else
+        high = get_u16(pc + (n - 1) * elt_size + 2);
+    if (fc->ignore_case || high >= 256)
+        fc->high = TRUE;
+}
+
+/* Add to 'fc' the characters which can be matched first by the
+   bytecode at 'pos'. Return FALSE if a match may not start with a
+   character or if the bytecode is too complicated. */
+static BOOL re_compute_first_chars(REFirstChars *fc, const uint8_t *bc_buf,
+                                   int pos)
+{
+    int opcode, len;
+    uint32_t val, c;
+
+    for(;;) {
+        if (--fc->budget < 0)
+            return FALSE;
+        opcode = bc_buf[pos];
+        len = reopcode_info[opcode].size;
+        switch(opcode) {
+        case REOP_char:
+            re_first_add_char(fc, get_u16(bc_buf + pos + 1));
+            return TRUE;
+        case REOP_char32:
+            re_first_add_char(fc, get_u32(bc_buf + pos + 1));
+            return TRUE;
+        case REOP_dot:
+        case REOP_any:
+            for(c = 0; c < 256; c++) {
+                if (opcode == REOP_any || (c != '\n' && c != '\r'))
+                    re_first_add(fc, c);
+            }
+            fc->high = TRUE;
+            return TRUE;
+        case REOP_range:
+        case REOP_range32:
+            re_first_add_range(fc, bc_buf + pos + 1, opcode == REOP_range32);
+            return TRUE;
+        case REOP_line_start:
+        case REOP_line_end:
+        case REOP_word_boundary:
+        case REOP_not_word_boundary:
+        case REOP_save_start:
+        case REOP_save_end:
+        case REOP_save_reset:
+        case REOP_push_i32:
+        case REOP_drop:
+        case REOP_push_char_pos:
+            /* no character is matched */
+            pos += len;
+            break;
+        case REOP_goto:
+            val = get_u32(bc_buf + pos + 1);
+            pos += len + (int)val;
+            break;
+        case REOP_split_goto_first:
+        case REOP_split_next_first:
+        case REOP_loop:
+        case REOP_bne_char_pos:
+            /* both branches may be taken */
+            val = get_u32(bc_buf + pos + 1);
+            if (!re_compute_first_chars(fc, bc_buf, pos + len + (int)val))
+                return FALSE;
+            pos += len;
+            break;
+        case REOP_simple_greedy_quant:
+            if (!re_compute_first_chars(fc, bc_buf, pos + len))
+                return FALSE;
+            if (get_u32(bc_buf + pos + 5) != 0)
+                return TRUE;
+            val = get_u32(bc_buf + pos + 1);
+            pos += len + (int)val;
+            break;
+        default:
+            /* match, lookahead, back reference, lookbehind */
+            return FALSE;
+        }
+    }
+}
+
+/* Insert a REOP_first_chars opcode at the start of the bytecode if
+   the set of the characters which can start a match is smaller than
+   all the characters. Return -1 if memory error. */
+static int re_emit_first_chars(REParseState *s)
+{
+    REFirstChars fc_s, *fc = &fc_s;
+    uint8_t *bc_buf;
+    int flags, n, i, c, pos;
+
+    memset(fc, 0, sizeof(*fc));
+    fc->budget = RE_FIRST_BUDGET;
+    fc->ignore_case = s->ignore_case;
+    fc->is_utf16 = s->is_utf16;
+    bc_buf = s->byte_code.buf + RE_HEADER_LEN;
+    flags = 0;
+    /* skip the save_start of the whole match */
+    pos = reopcode_info[REOP_save_start].size;
+    if (bc_buf[pos] == REOP_line_start &&
+        !(s->re_flags & LRE_FLAG_MULTILINE))
+        flags |= RE_FIRST_ANCHORED;
+    if (!re_compute_first_chars(fc, bc_buf, 0)) {
+        if (!flags)
+            return 0;
+        memset(fc->bitmap, 0xff, sizeof(fc->bitmap));
+        fc->high = TRUE;
+    }
+    if (fc->high)
+        flags |= RE_FIRST_HIGH;
+    n = 0;
+    c = 0;
+    for(i = 0; i < 256; i++) {
+        if ((fc->bitmap[i >> 3] >> (i & 7)) & 1) {
+            n++;
+            c = i;
+        }
+    }
+    if (n == 1 && !fc->high)
+        flags |= RE_FIRST_SINGLE;
+    if (n == 256 && fc->high && !(flags & RE_FIRST_ANCHORED))
+        return 0;
+    if (dbuf_insert(&s->byte_code, RE_HEADER_LEN,
+                    reopcode_info[REOP_first_chars].size))
+        return -1;
+    bc_buf = s->byte_code.buf + RE_HEADER_LEN;
+    bc_buf[0] = REOP_first_chars;
+    bc_buf[1 + RE_FIRST_FLAGS] = flags;
+    bc_buf[1 + RE_FIRST_CHAR] = c;
+    memcpy(bc_buf + 1 + RE_FIRST_BITMAP, fc->bitmap, sizeof(fc->bitmap));
+    return 0;
+}
+
 /* 'buf' must be a zero terminated UTF-8 string of length buf_len.
    Return NULL if error and allocate an error message in *perror_msg,
    otherwise the compiled bytecode and its length in plen.
@@ -1848,15 +2054,7 @@ uint8_t *lre_compile(int *plen, char *error_msg, int error_msg_size,
     dbuf_putc(&s->byte_code, 0); /* stack size */
     dbuf_put_u32(&s->byte_code, 0); /* bytecode length */
     
-    if (!is_sticky) {
-        /* iterate thru all positions (about the same as .*?( ... ) )
-           .  We do it without an explicit loop so that lock step
-           thread execution will be possible in an optimized
-           implementation */
-        re_emit_op_u32(s, REOP_split_goto_first, 1 + 5);
-        re_emit_op(s, REOP_any);
-        re_emit_op_u32(s, REOP_goto, -(5 + 1 + 5));
-    }
+    /* if not sticky, lre_exec() iterates thru all the start positions */
     re_emit_op_u8(s, REOP_save_start, 0);
 
     if (re_parse_disjunction(s, FALSE)) {
@@ -1881,6 +2079,11 @@ uint8_t *lre_compile(int *plen, char *error_msg, int error_msg_size,
         re_parse_out_of_memory(s);
         goto error;
     }
+
+    if (!is_sticky && re_emit_first_chars(s)) {
+        re_parse_out_of_memory(s);
+        goto error;
+    }
     
     stack_size = compute_stack_size(s->byte_code.buf, s->byte_code.size);
     if (stack_size < 0) {
@@ -2493,6 +2696,42 @@ static intptr_t lre_exec_backtrack(REExecContext *s, uint8_t **capture,
     }
 }
 
+/* Return the first position at or after 'cptr' whose character is
+   accepted by the REOP_first_chars operands 'fc', or NULL if none. */
+static const uint8_t *lre_find_first_char(REExecContext *s, const uint8_t *fc,
+                                          const uint8_t *cptr)
+{
+    const uint8_t *cbuf_end, *cptr1, *bitmap;
+    int cbuf_type;
+    uint32_t c;
+
+    cbuf_type = s->cbuf_type;
+    cbuf_end = s->cbuf_end;
+    bitmap = fc + RE_FIRST_BITMAP;
+    if (cbuf_type == 0) {
+        if (fc[RE_FIRST_FLAGS] & RE_FIRST_SINGLE)
+            return memchr(cptr, fc[RE_FIRST_CHAR], cbuf_end - cptr);
+        for(; cptr < cbuf_end; cptr++) {
+            c = *cptr;
+            if ((bitmap[c >> 3] >> (c & 7)) & 1)
+                return cptr;
+        }
+    } else {
+        while (cptr < cbuf_end) {
+            cptr1 = cptr;
+            GET_CHAR(c, cptr, cbuf_end);
+            if (c < 256) {
+                if ((bitmap[c >> 3] >> (c & 7)) & 1)
+                    return cptr1;
+            } else {
+                if (fc[RE_FIRST_FLAGS] & RE_FIRST_HIGH)
+                    return cptr1;
+            }
+        }
+    }
+    return NULL;
+}
+
 /* Return 1 if match, 0 if not match or -1 if error. cindex is the
    starting position of the match and must be such as 0 <= cindex <=
    clen. */
@@ -2503,6 +2742,9 @@ int lre_exec(uint8_t **capture,
     REExecContext s_s, *s = &s_s;
     int re_flags, i, alloca_size, ret;
     StackInt *stack_buf;
+    const uint8_t *pc, *cptr, *cbuf_end, *fc;
+    uint32_t c;
+    BOOL anchored;
     
     re_flags = bc_buf[RE_HEADER_FLAGS];
     s->multi_line = (re_flags & LRE_FLAG_MULTILINE) != 0;
@@ -2524,12 +2766,45 @@ int lre_exec(uint8_t **capture,
     s->state_stack_len = 0;
     s->state_stack_size = 0;
     
-    for(i = 0; i < s->capture_count * 2; i++)
-        capture[i] = NULL;
     alloca_size = s->stack_size_max * sizeof(stack_buf[0]);
     stack_buf = alloca(alloca_size);
-    ret = lre_exec_backtrack(s, capture, stack_buf, 0, bc_buf + RE_HEADER_LEN,
-                             cbuf + (cindex << cbuf_type), FALSE);
+
+    pc = bc_buf + RE_HEADER_LEN;
+    fc = NULL;
+    if (*pc == REOP_first_chars) {
+        fc = pc + 1;
+        pc += reopcode_info[REOP_first_chars].size;
+    }
+    cptr = cbuf + (cindex << cbuf_type);
+    if (re_flags & LRE_FLAG_STICKY) {
+        for(i = 0; i < s->capture_count * 2; i++)
+            capture[i] = NULL;
+        ret = lre_exec_backtrack(s, capture, stack_buf, 0, pc, cptr, FALSE);
+    } else {
+        /* try all the start positions, skipping those which cannot
+           start a match */
+        cbuf_type = s->cbuf_type;
+        cbuf_end = s->cbuf_end;
+        anchored = fc && (fc[RE_FIRST_FLAGS] & RE_FIRST_ANCHORED);
+        ret = 0;
+        if (anchored && cptr != cbuf)
+            goto done;
+        for(;;) {
+            if (fc && !anchored) {
+                cptr = lre_find_first_char(s, fc, cptr);
+                if (!cptr)
+                    break;
+            }
+            for(i = 0; i < s->capture_count * 2; i++)
+                capture[i] = NULL;
+            ret = lre_exec_backtrack(s, capture, stack_buf, 0, pc, cptr,
+                                     FALSE);
+            if (ret != 0 || anchored || cptr >= cbuf_end)
+                break;
+            GET_CHAR(c, cptr, cbuf_end);
+        }
+    }
+ done:
     lre_realloc(s->opaque, s->state_stack, 0);
     return ret;
 }
@@ -2552,7 +2827,7 @@ const char *lre_get_groupnames(const uint8_t *bc_buf)
     if ((lre_get_flags(bc_buf) & LRE_FLAG_NAMED_GROUPS) == 0)
         return NULL;
     re_bytecode_len = get_u32(bc_buf + 3);
-    return (const char *)(bc_buf + 7 + re_bytecode_len);
+    return (const char *)(bc_buf + RE_HEADER_LEN + re_bytecode_len);
 }
 
 #ifdef TEST
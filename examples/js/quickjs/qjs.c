@@ -299,6 +299,8 @@ void help(void)
            "-d  --dump         dump the memory usage stats\n"
            "    --memory-limit n       limit the memory usage to 'n' bytes\n"
            "    --stack-size n         limit the stack size to 'n' bytes\n"
+           "    --gc-generational      only scan the new objects in most collections\n"
+           "    --gc-slice n           limit the automatic collections to about 'n' us\n"
            "    --unhandled-rejection  dump unhandled promise rejections\n"
            "-q  --quit         just instantiate the interpreter and quit\n");
     exit(1);
@@ -325,6 +327,8 @@ int main(int argc, char **argv)
     int load_jscalc;
 #endif
     size_t stack_size = 0;
+    int gc_generational = 0;
+    int gc_slice_time = 0;
     
 #ifdef CONFIG_BIGNUM
     /* load jscalc runtime if invoked as 'qjscalc' */
@@ -445,6 +449,18 @@ int main(int argc, char **argv)
                 stack_size = (size_t)strtod(argv[optind++], NULL);
                 continue;
             }
+            if (!strcmp(longopt, "gc-generational")) {
+                gc_generational = 1;
+                continue;
+            }
+            if (!strcmp(longopt, "gc-slice")) {
+                if (optind >= argc) {
+                    fprintf(stderr, "expecting GC slice time");
+                    exit(1);
+                }
+                gc_slice_time = atoi(argv[optind++]);
+                continue;
+            }
             if (opt) {
                 fprintf(stderr, "qjs: unknown option '-%c'\n", opt);
             } else {
@@ -478,6 +494,10 @@ int main(int argc, char **argv)
         fprintf(stderr, "qjs: cannot allocate JS context\n");
         exit(2);
     }
+    if (gc_generational)
+        JS_SetGCGenerational(rt, TRUE);
+    if (gc_slice_time != 0)
+        JS_SetGCSliceTime(rt, gc_slice_time);
 
     /* loader for ES6 modules */
     JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
@@ -0,0 +1,227 @@
+/* Hash values of the predefined atoms */
+/* Automatically generated file - do not edit */
+
+#define JS_ATOM_INIT_HASH_null 0x14ed0e88
+#define JS_ATOM_INIT_HASH_false 0x007f337a
+#define JS_ATOM_INIT_HASH_true 0x1b6b6737
+#define JS_ATOM_INIT_HASH_if 0x00017a76
+#define JS_ATOM_INIT_HASH_else 0x0b215eea
+#define JS_ATOM_INIT_HASH_return 0x1b081491
+#define JS_ATOM_INIT_HASH_var 0x01928306
+#define JS_ATOM_INIT_HASH_this 0x1b60cd07
+#define JS_ATOM_INIT_HASH_delete 0x082273ac
+#define JS_ATOM_INIT_HASH_void 0x1d9358fd
+#define JS_ATOM_INIT_HASH_typeof 0x0d2f15ea
+#define JS_ATOM_INIT_HASH_new 0x018a159f
+#define JS_ATOM_INIT_HASH_in 0x00017a7e
+#define JS_ATOM_INIT_HASH_instanceof 0x1d1cf505
+#define JS_ATOM_INIT_HASH_do 0x0001755c
+#define JS_ATOM_INIT_HASH_while 0x17f4cb88
+#define JS_ATOM_INIT_HASH_for 0x0181ae58
+#define JS_ATOM_INIT_HASH_break 0x1e3901ee
+#define JS_ATOM_INIT_HASH_continue 0x1163f230
+#define JS_ATOM_INIT_HASH_switch 0x13bbdead
+#define JS_ATOM_INIT_HASH_case 0x08ea9a21
+#define JS_ATOM_INIT_HASH_default 0x080b39e8
+#define JS_ATOM_INIT_HASH_throw 0x007c1e45
+#define JS_ATOM_INIT_HASH_try 0x01907822
+#define JS_ATOM_INIT_HASH_catch 0x09056472
+#define JS_ATOM_INIT_HASH_finally 0x0426eafa
+#define JS_ATOM_INIT_HASH_function 0x01bc22b1
+#define JS_ATOM_INIT_HASH_debugger 0x1d645ba2
+#define JS_ATOM_INIT_HASH_with 0x1ea2a37f
+#define JS_ATOM_INIT_HASH_class 0x14dec707
+#define JS_ATOM_INIT_HASH_const 0x182d3c8a
+#define JS_ATOM_INIT_HASH_enum 0x0b237d62
+#define JS_ATOM_INIT_HASH_export 0x0e50fdcd
+#define JS_ATOM_INIT_HASH_extends 0x1f063ef8
+#define JS_ATOM_INIT_HASH_import 0x0bc83d3e
+#define JS_ATOM_INIT_HASH_super 0x11671aa2
+#define JS_ATOM_INIT_HASH_implements 0x06f7e4a9
+#define JS_ATOM_INIT_HASH_interface 0x092b2db0
+#define JS_ATOM_INIT_HASH_let 0x0187f93a
+#define JS_ATOM_INIT_HASH_package 0x17b79c55
+#define JS_ATOM_INIT_HASH_private 0x0390faca
+#define JS_ATOM_INIT_HASH_protected 0x07c5f985
+#define JS_ATOM_INIT_HASH_public 0x0b062632
+#define JS_ATOM_INIT_HASH_static 0x138d11f7
+#define JS_ATOM_INIT_HASH_yield 0x135cf1dc
+#define JS_ATOM_INIT_HASH_await 0x067551bd
+#define JS_ATOM_INIT_HASH_empty_string 0x00000001
+#define JS_ATOM_INIT_HASH_length 0x06f8edf7
+#define JS_ATOM_INIT_HASH_fileName 0x08eba4d0
+#define JS_ATOM_INIT_HASH_lineNumber 0x0dd3569e
+#define JS_ATOM_INIT_HASH_message 0x02bf0f06
+#define JS_ATOM_INIT_HASH_errors 0x0177c634
+#define JS_ATOM_INIT_HASH_stack 0x1041af57
+#define JS_ATOM_INIT_HASH_name 0x14d7f3b4
+#define JS_ATOM_INIT_HASH_toString 0x15becee5
+#define JS_ATOM_INIT_HASH_toLocaleString 0x04732bf7
+#define JS_ATOM_INIT_HASH_valueOf 0x067a59a7
+#define JS_ATOM_INIT_HASH_eval 0x0b2bda5d
+#define JS_ATOM_INIT_HASH_prototype 0x1dec1b59
+#define JS_ATOM_INIT_HASH_constructor 0x09c4a631
+#define JS_ATOM_INIT_HASH_configurable 0x066667aa
+#define JS_ATOM_INIT_HASH_writable 0x0fbb9aa9
+#define JS_ATOM_INIT_HASH_enumerable 0x17b4c6a9
+#define JS_ATOM_INIT_HASH_value 0x13358b98
+#define JS_ATOM_INIT_HASH_get 0x0182b245
+#define JS_ATOM_INIT_HASH_set 0x018f5c91
+#define JS_ATOM_INIT_HASH_of 0x000180a0
+#define JS_ATOM_INIT_HASH___proto__ 0x1081320f
+#define JS_ATOM_INIT_HASH_undefined 0x1391bcaf
+#define JS_ATOM_INIT_HASH_number 0x07bea6aa
+#define JS_ATOM_INIT_HASH_boolean 0x11cc530f
+#define JS_ATOM_INIT_HASH_string 0x05f054ca
+#define JS_ATOM_INIT_HASH_object 0x11ddb2a0
+#define JS_ATOM_INIT_HASH_symbol 0x125607b1
+#define JS_ATOM_INIT_HASH_integer 0x1c163065
+#define JS_ATOM_INIT_HASH_unknown 0x1a1addd9
+#define JS_ATOM_INIT_HASH_arguments 0x1e06445d
+#define JS_ATOM_INIT_HASH_callee 0x1be70b6f
+#define JS_ATOM_INIT_HASH_caller 0x1be70b7c
+#define JS_ATOM_INIT_HASH__eval_ 0x03a7f3d7
+#define JS_ATOM_INIT_HASH__ret_ 0x09c808e0
+#define JS_ATOM_INIT_HASH__var_ 0x0e1a1f6a
+#define JS_ATOM_INIT_HASH__arg_var_ 0x0bec3ee3
+#define JS_ATOM_INIT_HASH__with_ 0x02b095c5
+#define JS_ATOM_INIT_HASH_lastIndex 0x11867383
+#define JS_ATOM_INIT_HASH_target 0x134acfaa
+#define JS_ATOM_INIT_HASH_index 0x06116c31
+#define JS_ATOM_INIT_HASH_input 0x061e26e9
+#define JS_ATOM_INIT_HASH_defineProperties 0x1b4946f7
+#define JS_ATOM_INIT_HASH_apply 0x1eee1b55
+#define JS_ATOM_INIT_HASH_join 0x109064f3
+#define JS_ATOM_INIT_HASH_concat 0x16683ba5
+#define JS_ATOM_INIT_HASH_split 0x0bf70049
+#define JS_ATOM_INIT_HASH_construct 0x0b4c5396
+#define JS_ATOM_INIT_HASH_getPrototypeOf 0x05300f94
+#define JS_ATOM_INIT_HASH_setPrototypeOf 0x11a7d668
+#define JS_ATOM_INIT_HASH_isExtensible 0x1ec5152e
+#define JS_ATOM_INIT_HASH_preventExtensions 0x12c48273
+#define JS_ATOM_INIT_HASH_has 0x0183bc59
+#define JS_ATOM_INIT_HASH_deleteProperty 0x1d2fe111
+#define JS_ATOM_INIT_HASH_defineProperty 0x035ee5a1
+#define JS_ATOM_INIT_HASH_getOwnPropertyDescriptor 0x156a19f5
+#define JS_ATOM_INIT_HASH_ownKeys 0x027d54b9
+#define JS_ATOM_INIT_HASH_add 0x017c5c08
+#define JS_ATOM_INIT_HASH_done 0x0a0ef003
+#define JS_ATOM_INIT_HASH_next 0x14dc37d4
+#define JS_ATOM_INIT_HASH_values 0x1c02699b
+#define JS_ATOM_INIT_HASH_source 0x17618b54
+#define JS_ATOM_INIT_HASH_flags 0x0c60ead6
+#define JS_ATOM_INIT_HASH_global 0x1e4f2c3c
+#define JS_ATOM_INIT_HASH_unicode 0x13d69fcc
+#define JS_ATOM_INIT_HASH_raw 0x018e4a47
+#define JS_ATOM_INIT_HASH_new_target 0x0cee6f90
+#define JS_ATOM_INIT_HASH_this_active_func 0x18af09be
+#define JS_ATOM_INIT_HASH_home_object 0x0e95a32a
+#define JS_ATOM_INIT_HASH_computed_field 0x138f9c0b
+#define JS_ATOM_INIT_HASH_static_computed_field 0x07de42e8
+#define JS_ATOM_INIT_HASH_class_fields_init 0x1d5715ea
+#define JS_ATOM_INIT_HASH_brand 0x0620bc12
+#define JS_ATOM_INIT_HASH_hash_constructor 0x0827e460
+#define JS_ATOM_INIT_HASH_as 0x0001724b
+#define JS_ATOM_INIT_HASH_from 0x0c3d4453
+#define JS_ATOM_INIT_HASH_meta 0x13c69f4e
+#define JS_ATOM_INIT_HASH__default_ 0x026802b2
+#define JS_ATOM_INIT_HASH__star_ 0x00000131
+#define JS_ATOM_INIT_HASH_Module 0x04d22895
+#define JS_ATOM_INIT_HASH_then 0x1b60c8e6
+#define JS_ATOM_INIT_HASH_resolve 0x0199f503
+#define JS_ATOM_INIT_HASH_reject 0x101f56b8
+#define JS_ATOM_INIT_HASH_promise 0x08db9482
+#define JS_ATOM_INIT_HASH_proxy 0x16a332d5
+#define JS_ATOM_INIT_HASH_revoke 0x1d2ce0df
+#define JS_ATOM_INIT_HASH_async 0x02385a0b
+#define JS_ATOM_INIT_HASH_exec 0x0b2dfad2
+#define JS_ATOM_INIT_HASH_groups 0x0d67a995
+#define JS_ATOM_INIT_HASH_status 0x138d1e5b
+#define JS_ATOM_INIT_HASH_reason 0x066bf2a5
+#define JS_ATOM_INIT_HASH_globalThis 0x0e0a4b82
+#define JS_ATOM_INIT_HASH_bigint 0x083e08d8
+#define JS_ATOM_INIT_HASH_bigfloat 0x078145ad
+#define JS_ATOM_INIT_HASH_bigdecimal 0x184e3552
+#define JS_ATOM_INIT_HASH_roundingMode 0x11f18c88
+#define JS_ATOM_INIT_HASH_maximumSignificantDigits 0x091fa5ea
+#define JS_ATOM_INIT_HASH_maximumFractionDigits 0x0983a72f
+#define JS_ATOM_INIT_HASH_not_equal 0x1753fe81
+#define JS_ATOM_INIT_HASH_timed_out 0x17ef57bf
+#define JS_ATOM_INIT_HASH_ok 0x000180a5
+#define JS_ATOM_INIT_HASH_toJSON 0x0035facc
+#define JS_ATOM_INIT_HASH_Object 0x1f38ddc0
+#define JS_ATOM_INIT_HASH_Array 0x1baea8f8
+#define JS_ATOM_INIT_HASH_Error 0x105c4cd7
+#define JS_ATOM_INIT_HASH_Number 0x1519d1ca
+#define JS_ATOM_INIT_HASH_String 0x134b7fea
+#define JS_ATOM_INIT_HASH_Boolean 0x0a75a0ef
+#define JS_ATOM_INIT_HASH_Symbol 0x1fb132d1
+#define JS_ATOM_INIT_HASH_Arguments 0x06906c3d
+#define JS_ATOM_INIT_HASH_Math 0x110fdbb1
+#define JS_ATOM_INIT_HASH_JSON 0x0dc031e1
+#define JS_ATOM_INIT_HASH_Date 0x074da49f
+#define JS_ATOM_INIT_HASH_Function 0x17ab23d1
+#define JS_ATOM_INIT_HASH_GeneratorFunction 0x01855bda
+#define JS_ATOM_INIT_HASH_ForInIterator 0x14ea15c3
+#define JS_ATOM_INIT_HASH_RegExp 0x1a181442
+#define JS_ATOM_INIT_HASH_ArrayBuffer 0x1be38340
+#define JS_ATOM_INIT_HASH_SharedArrayBuffer 0x139959eb
+#define JS_ATOM_INIT_HASH_Uint8ClampedArray 0x1eb01ab4
+#define JS_ATOM_INIT_HASH_Int8Array 0x044405ff
+#define JS_ATOM_INIT_HASH_Uint8Array 0x0662965c
+#define JS_ATOM_INIT_HASH_Int16Array 0x11a1fa56
+#define JS_ATOM_INIT_HASH_Uint16Array 0x1f0849e1
+#define JS_ATOM_INIT_HASH_Int32Array 0x07c2cadc
+#define JS_ATOM_INIT_HASH_Uint32Array 0x15291a67
+#define JS_ATOM_INIT_HASH_BigInt64Array 0x0b6f8c3b
+#define JS_ATOM_INIT_HASH_BigUint64Array 0x0e172dfa
+#define JS_ATOM_INIT_HASH_Float32Array 0x19d999bf
+#define JS_ATOM_INIT_HASH_Float64Array 0x17b407c0
+#define JS_ATOM_INIT_HASH_DataView 0x19149548
+#define JS_ATOM_INIT_HASH_BigInt 0x15776dd8
+#define JS_ATOM_INIT_HASH_BigFloat 0x18039aad
+#define JS_ATOM_INIT_HASH_BigFloatEnv 0x1c1fd978
+#define JS_ATOM_INIT_HASH_BigDecimal 0x16e67a52
+#define JS_ATOM_INIT_HASH_OperatorSet 0x12e6b4ad
+#define JS_ATOM_INIT_HASH_Operators 0x033a0876
+#define JS_ATOM_INIT_HASH_Map 0x01673d2b
+#define JS_ATOM_INIT_HASH_Set 0x016d9671
+#define JS_ATOM_INIT_HASH_WeakMap 0x0be48f13
+#define JS_ATOM_INIT_HASH_WeakSet 0x0beae859
+#define JS_ATOM_INIT_HASH_Map_Iterator 0x06eb2ceb
+#define JS_ATOM_INIT_HASH_Set_Iterator 0x10fb1f55
+#define JS_ATOM_INIT_HASH_Array_Iterator 0x088efac6
+#define JS_ATOM_INIT_HASH_String_Iterator 0x0bdf27e4
+#define JS_ATOM_INIT_HASH_RegExp_String_Iterator 0x1c617acf
+#define JS_ATOM_INIT_HASH_Generator 0x08b1234a
+#define JS_ATOM_INIT_HASH_Proxy 0x113686b5
+#define JS_ATOM_INIT_HASH_Promise 0x0184e262
+#define JS_ATOM_INIT_HASH_PromiseResolveFunction 0x0971520a
+#define JS_ATOM_INIT_HASH_PromiseRejectFunction 0x1e403999
+#define JS_ATOM_INIT_HASH_AsyncFunction 0x075c4d3b
+#define JS_ATOM_INIT_HASH_AsyncFunctionResolve 0x172b5bd9
+#define JS_ATOM_INIT_HASH_AsyncFunctionReject 0x0e8041b2
+#define JS_ATOM_INIT_HASH_AsyncGeneratorFunction 0x1fc82840
+#define JS_ATOM_INIT_HASH_AsyncGenerator 0x07b2af30
+#define JS_ATOM_INIT_HASH_EvalError 0x00778ebb
+#define JS_ATOM_INIT_HASH_RangeError 0x12fdbe5c
+#define JS_ATOM_INIT_HASH_ReferenceError 0x02f79d9e
+#define JS_ATOM_INIT_HASH_SyntaxError 0x13bc728c
+#define JS_ATOM_INIT_HASH_TypeError 0x16c4f8dd
+#define JS_ATOM_INIT_HASH_URIError 0x1e962805
+#define JS_ATOM_INIT_HASH_InternalError 0x0d11fe12
+#define JS_ATOM_INIT_HASH_Private_brand 0x0620bc12
+#define JS_ATOM_INIT_HASH_Symbol_toPrimitive 0x1710d7df
+#define JS_ATOM_INIT_HASH_Symbol_iterator 0x03230b63
+#define JS_ATOM_INIT_HASH_Symbol_match 0x0b94b2f8
+#define JS_ATOM_INIT_HASH_Symbol_matchAll 0x0d9d3c19
+#define JS_ATOM_INIT_HASH_Symbol_replace 0x02bf9c37
+#define JS_ATOM_INIT_HASH_Symbol_search 0x136627e5
+#define JS_ATOM_INIT_HASH_Symbol_split 0x0ad45905
+#define JS_ATOM_INIT_HASH_Symbol_toStringTag 0x1f4aee71
+#define JS_ATOM_INIT_HASH_Symbol_isConcatSpreadable 0x09b03680
+#define JS_ATOM_INIT_HASH_Symbol_hasInstance 0x1889766a
+#define JS_ATOM_INIT_HASH_Symbol_species 0x15cbdc5f
+#define JS_ATOM_INIT_HASH_Symbol_unscopables 0x0ab072d2
+#define JS_ATOM_INIT_HASH_Symbol_asyncIterator 0x08a08fe5
+#define JS_ATOM_INIT_HASH_Symbol_operatorSet 0x081b0149
@@ -721,6 +721,41 @@ static JSValue js_std_gc(JSContext *ctx, JSValueConst this_val,
     return JS_UNDEFINED;
 }
 
+static JSValue js_std_gcStats(JSContext *ctx, JSValueConst this_val,
+                              int argc, JSValueConst *argv)
+{
+    JSGCStats st;
+    JSValue obj;
+
+    JS_GetGCStats(JS_GetRuntime(ctx), &st);
+    obj = JS_NewObject(ctx);
+    if (JS_IsException(obj))
+        return obj;
+    JS_DefinePropertyValueStr(ctx, obj, "count",
+                              JS_NewInt64(ctx, st.gc_count), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "minorCount",
+                              JS_NewInt64(ctx, st.minor_gc_count), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "pauseTime",
+                              JS_NewInt64(ctx, st.pause_time), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "objectsScanned",
+                              JS_NewInt64(ctx, st.objects_scanned), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "objectsFreed",
+                              JS_NewInt64(ctx, st.objects_freed), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "bytesFreed",
+                              JS_NewInt64(ctx, st.bytes_freed), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "lastPauseTime",
+                              JS_NewInt64(ctx, st.last_pause_time), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "lastObjectsScanned",
+                              JS_NewInt64(ctx, st.last_objects_scanned), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "lastObjectsFreed",
+                              JS_NewInt64(ctx, st.last_objects_freed), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "lastBytesFreed",
+                              JS_NewInt64(ctx, st.last_bytes_freed), JS_PROP_C_W_E);
+    JS_DefinePropertyValueStr(ctx, obj, "threshold",
+                              JS_NewInt64(ctx, st.threshold), JS_PROP_C_W_E);
+    return obj;
+}
+
 static int interrupt_handler(JSRuntime *rt, void *opaque)
 {
     return (os_pending_signals >> SIGINT) & 1;
@@ -1483,6 +1518,7 @@ static const JSCFunctionListEntry js_std_error_props[] = {
 static const JSCFunctionListEntry js_std_funcs[] = {
     JS_CFUNC_DEF("exit", 1, js_std_exit ),
     JS_CFUNC_DEF("gc", 0, js_std_gc ),
+    JS_CFUNC_DEF("gcStats", 0, js_std_gcStats ),
     JS_CFUNC_DEF("evalScript", 1, js_evalScript ),
     JS_CFUNC_DEF("loadScript", 1, js_loadScript ),
     JS_CFUNC_DEF("getenv", 1, js_std_getenv ),
@@ -3877,13 +3913,15 @@ void js_std_promise_rejection_tracker(JSContext *ctx, JSValueConst promise,
 /* main loop which calls the user JS callbacks */
 void js_std_loop(JSContext *ctx)
 {
+    JSRuntime *rt = JS_GetRuntime(ctx);
     JSContext *ctx1;
-    int err;
+    int err, slice_time;
 
+    slice_time = JS_GetGCSliceTime(rt);
     for(;;) {
         /* execute the pending jobs */
         for(;;) {
-            err = JS_ExecutePendingJob(JS_GetRuntime(ctx), &ctx1);
+            err = JS_ExecutePendingJob(rt, &ctx1);
             if (err <= 0) {
                 if (err < 0) {
                     js_std_dump_error(ctx1);
@@ -3892,6 +3930,10 @@ void js_std_loop(JSContext *ctx)
             }
         }
 
+        /* collect a GC slice while waiting for the next event */
+        if (slice_time > 0)
+            JS_RunGCSlice(rt, slice_time);
+
         if (!os_poll_func || os_poll_func(ctx))
             break;
     }
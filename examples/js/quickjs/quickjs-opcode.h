@@ -105,6 +105,7 @@ DEF(      tail_call, 3, 1, 0, npop) /* arguments are not counted in n_pop */
 DEF(    call_method, 3, 2, 1, npop) /* arguments are not counted in n_pop */
 DEF(tail_call_method, 3, 2, 0, npop) /* arguments are not counted in n_pop */
 DEF(     array_from, 3, 0, 1, npop) /* arguments are not counted in n_pop */
+DEF(object_template, 3, 1, 1, npop) /* fields... template -> obj. fields are not counted in n_pop */
 DEF(          apply, 3, 3, 1, u16)
 DEF(         return, 1, 1, 0, none)
 DEF(   return_undef, 1, 0, 0, none)
@@ -78,6 +78,23 @@
 #define CONFIG_STACK_CHECK
 #endif
 
+/* define them to leave builtins out of JS_NewContext() in small
+   builds. Without eval, only precompiled bytecode can be run and the
+   compiler is not linked:
+   CONFIG_NO_EVAL: no eval(), Function() nor JS_Eval() of source code
+   CONFIG_NO_PROXY: no Proxy object
+   CONFIG_NO_REFLECT: no Reflect object
+*/
+//#define CONFIG_NO_EVAL
+//#define CONFIG_NO_PROXY
+//#define CONFIG_NO_REFLECT
+
+#if !defined(__SANITIZE_ADDRESS__)
+/* allocate the objects, shapes and small strings from slabs. Disabled
+   with AddressSanitizer so that it checks each block. */
+#define CONFIG_SLAB
+#endif
+
 
 /* dump object free */
 //#define DUMP_FREE
@@ -207,6 +224,7 @@ typedef enum JSErrorEnum {
 #define __exception __attribute__((warn_unused_result))
 
 typedef struct JSShape JSShape;
+typedef struct JSONShapeKeys JSONShapeKeys;
 typedef struct JSString JSString;
 typedef struct JSString JSAtomStruct;
 
@@ -238,9 +256,33 @@ typedef struct {
 } JSNumericOperations;
 #endif
 
+/* Slab allocator for the small blocks whose size is known when they
+   are freed (JSObject, JSShape and JSString). There is one free list
+   per size class. The blocks are carved from pages of
+   JS_SLAB_PAGE_SIZE bytes allocated with js_malloc_rt(). */
+#define JS_SLAB_SIZE_BITS   4  /* the size classes are multiples of 16 */
+#define JS_SLAB_CLASS_COUNT 16
+#define JS_SLAB_MAX_SIZE    (JS_SLAB_CLASS_COUNT << JS_SLAB_SIZE_BITS)
+#define JS_SLAB_PAGE_SIZE   (16 * 1024)
+
+typedef struct JSSlabPage {
+    struct JSSlabPage *next;
+    /* the blocks follow, at offset 1 << JS_SLAB_SIZE_BITS */
+} JSSlabPage;
+
+typedef struct JSSlabClass {
+    void *free_list; /* free blocks, linked by their first word */
+    uint8_t *ptr, *end; /* never allocated blocks of the last page */
+    JSSlabPage *pages;
+    int page_count;
+    int free_count; /* free blocks, including [ptr, end) */
+} JSSlabClass;
+
 struct JSRuntime {
     JSMallocFunctions mf;
     JSMallocState malloc_state;
+    JSSlabClass slab_classes[JS_SLAB_CLASS_COUNT];
+    size_t slab_free_size; /* size of the free slab blocks in bytes */
     const char *rt_info;
 
     int atom_hash_size; /* power of two */
@@ -261,8 +303,23 @@ struct JSRuntime {
     /* list of JSGCObjectHeader.link. Used during JS_FreeValueRT() */
     struct list_head gc_zero_ref_count_list; 
     struct list_head tmp_obj_list; /* used during GC */
+    /* list of JSGCObjectHeader.link. JS objects allocated since the
+       last collection when the young generation is enabled */
+    struct list_head gc_young_obj_list;
+    BOOL gc_generational : 8;
     JSGCPhaseEnum gc_phase : 8;
     size_t malloc_gc_threshold;
+    size_t malloc_gc_threshold_min; /* set by JS_SetGCThreshold() */
+    int gc_growth; /* heap growth allowed before the next GC, in percent */
+    int gc_slice_time; /* max duration of the automatic GC in us, 0 if none */
+    int gc_slice_left; /* old objects which can still be added to a slice */
+    int64_t gc_slice_debt; /* old objects to be scanned by the next slices */
+    int64_t gc_end_time; /* end of the last automatic GC, in us */
+    uint32_t gc_old_count; /* number of GC objects kept by the last full GC */
+    /* objects promoted since the last full GC, less the old objects
+       freed by the GC slices */
+    int gc_promoted_count;
+    JSGCStats gc_stats;
 #ifdef DUMP_LEAKS
     struct list_head string_list; /* list of JSString.link */
 #endif
@@ -404,12 +461,39 @@ typedef enum {
     JS_AUTOINIT_ID_PROTOTYPE,
     JS_AUTOINIT_ID_MODULE_NS,
     JS_AUTOINIT_ID_PROP,
+    JS_AUTOINIT_ID_INTRINSIC,
 } JSAutoInitIDEnum;
 
+/* intrinsics which JS_NewContext() only creates when they are first
+   used */
+typedef enum {
+    JS_LAZY_INTRINSIC_DATE,
+    JS_LAZY_INTRINSIC_MAP_SET,
+    JS_LAZY_INTRINSIC_TYPED_ARRAYS,
+    JS_LAZY_INTRINSIC_COUNT,
+} JSLazyIntrinsicEnum;
+
 /* must be large enough to have a negligible runtime cost and small
    enough to call the interrupt callback often. */
 #define JS_INTERRUPT_COUNTER_INIT 10000
 
+/* size of the JSON.parse() property name and object shape caches */
+#define JSON_KEY_CACHE_BITS   8
+#define JSON_SHAPE_CACHE_BITS 6
+#define JSON_KEYS_CACHE_BITS  6
+
+/* quoted property names of a shape, used by JSON.stringify() */
+struct JSONShapeKeys {
+    JSShape *shape;
+    BOOL is_plain; /* FALSE if the objects of this shape must be
+                      handled by the generic algorithm */
+    BOOL is_ascii; /* TRUE if all the names are ASCII */
+    /* offsets in 'names' of the quoted name of each property
+       followed by ':'. An empty name means the property is skipped */
+    uint32_t *offsets;
+    uint8_t *names;
+};
+
 struct JSContext {
     JSGCObjectHeader header; /* must come first */
     JSRuntime *rt;
@@ -419,6 +503,10 @@ struct JSContext {
     int binary_object_size;
 
     JSShape *array_shape;   /* initial shape for Array objects */
+    /* recently parsed JSON property names and object shapes */
+    JSAtom json_key_cache[1 << JSON_KEY_CACHE_BITS];
+    JSShape *json_shape_cache[1 << JSON_SHAPE_CACHE_BITS];
+    JSONShapeKeys *json_keys_cache[1 << JSON_KEYS_CACHE_BITS];
 
     JSValue *class_proto;
     JSValue function_proto;
@@ -435,6 +523,10 @@ struct JSContext {
 
     JSValue global_obj; /* global object */
     JSValue global_var_obj; /* contains the global let/const definitions */
+    /* mask of the lazy intrinsics (JS_LAZY_INTRINSIC_x) not created yet */
+    uint8_t lazy_intrinsics;
+    /* the global bindings of the lazy intrinsics once they are created */
+    JSValue lazy_global_obj;
 
     uint64_t random_state;
 #ifdef CONFIG_BIGNUM
@@ -483,7 +575,7 @@ typedef enum {
     JS_ATOM_KIND_PRIVATE,
 } JSAtomKindEnum;
 
-#define JS_ATOM_HASH_MASK  ((1 << 30) - 1)
+#define JS_ATOM_HASH_MASK  ((1 << 29) - 1)
 
 struct JSString {
     JSRefCountHeader header; /* must come first, 32-bit */
@@ -492,7 +584,8 @@ struct JSString {
     /* for JS_ATOM_TYPE_SYMBOL: hash = 0, atom_type = 3,
        for JS_ATOM_TYPE_PRIVATE: hash = 1, atom_type = 3
        XXX: could change encoding to have one more bit in hash */
-    uint32_t hash : 30;
+    uint32_t hash : 29;
+    uint8_t in_slab : 1; /* allocated with js_slab_alloc() */
     uint8_t atom_type : 2; /* != 0 if atom, JS_ATOM_TYPE_x */
     uint32_t hash_next; /* atom_index for JS_ATOM_TYPE_SYMBOL */
 #ifdef DUMP_LEAKS
@@ -965,6 +1058,16 @@ static const char js_atom_init[] =
 #undef DEF
 ;
 
+#include "quickjs-atom-hash.h"
+
+/* hash of the predefined atoms, computed at build time */
+static const uint32_t js_atom_init_hash[JS_ATOM_END] = {
+    0, /* JS_ATOM_NULL */
+#define DEF(name, str) JS_ATOM_INIT_HASH_ ## name,
+#include "quickjs-atom.h"
+#undef DEF
+};
+
 typedef enum OPCodeFormat {
 #define FMT(f) OP_FMT_ ## f,
 #define DEF(id, size, n_pop, n_push, f)
@@ -1099,6 +1202,9 @@ static JSValue js_compile_regexp(JSContext *ctx, JSValueConst pattern,
 static JSValue js_regexp_constructor_internal(JSContext *ctx, JSValueConst ctor,
                                               JSValue pattern, JSValue bc);
 static void gc_decref(JSRuntime *rt);
+static void gc_promote_young(JSRuntime *rt);
+static int gc_slice_size(JSRuntime *rt, int budget_us);
+static void gc_collect(JSRuntime *rt, int old_count);
 static int JS_NewClass1(JSRuntime *rt, JSClassID class_id,
                         const JSClassDef *class_def, JSAtom name);
 
@@ -1219,6 +1325,7 @@ static void async_func_mark(JSRuntime *rt, JSAsyncFunctionState *s,
 static void JS_AddIntrinsicBasicObjects(JSContext *ctx);
 static void js_free_shape(JSRuntime *rt, JSShape *sh);
 static void js_free_shape_null(JSRuntime *rt, JSShape *sh);
+static void json_free_shape_keys(JSRuntime *rt, JSONShapeKeys *keys);
 static int js_shape_prepare_update(JSContext *ctx, JSObject *p,
                                    JSShapeProperty **pprs);
 static int init_shape_hash(JSRuntime *rt);
@@ -1249,6 +1356,16 @@ static JSValue js_module_ns_autoinit(JSContext *ctx, JSObject *p, JSAtom atom,
                                  void *opaque);
 static JSValue JS_InstantiateFunctionListItem2(JSContext *ctx, JSObject *p,
                                                JSAtom atom, void *opaque);
+static JSValue js_lazy_intrinsic_autoinit(JSContext *ctx, JSObject *p,
+                                          JSAtom atom, void *opaque);
+static JSValueConst js_get_class_proto(JSContext *ctx, JSClassID class_id);
+static void js_add_intrinsic_typed_arrays(JSContext *ctx);
+#ifdef CONFIG_ATOMICS
+void JS_AddIntrinsicAtomics(JSContext *ctx);
+#endif
+static int JS_DefineAutoInitProperty(JSContext *ctx, JSValueConst this_obj,
+                                     JSAtom prop, JSAutoInitIDEnum id,
+                                     void *opaque, int flags);
 void JS_SetUncatchableError(JSContext *ctx, JSValueConst val, BOOL flag);
 
 static const JSClassExoticMethods js_arguments_exotic_methods;
@@ -1257,23 +1374,358 @@ static const JSClassExoticMethods js_proxy_exotic_methods;
 static const JSClassExoticMethods js_module_ns_exotic_methods;
 static JSClassID js_class_id_alloc = JS_CLASS_INIT_COUNT;
 
+#ifdef CONFIG_SLAB
+
+static inline int js_slab_class(size_t size)
+{
+    return (size - 1) >> JS_SLAB_SIZE_BITS;
+}
+
+static inline int js_slab_page_blocks(int block_size)
+{
+    return (JS_SLAB_PAGE_SIZE - (1 << JS_SLAB_SIZE_BITS)) / block_size;
+}
+
+static no_inline int js_slab_new_page(JSRuntime *rt, JSSlabClass *sc,
+                                      int block_size)
+{
+    JSSlabPage *pg;
+    int n;
+
+    pg = js_malloc_rt(rt, JS_SLAB_PAGE_SIZE);
+    if (!pg)
+        return -1;
+    pg->next = sc->pages;
+    sc->pages = pg;
+    sc->page_count++;
+    n = js_slab_page_blocks(block_size);
+    sc->ptr = (uint8_t *)pg + (1 << JS_SLAB_SIZE_BITS);
+    sc->end = sc->ptr + n * block_size;
+    sc->free_count += n;
+    rt->slab_free_size += n * block_size;
+    return 0;
+}
+
+/* 'size' must be <= JS_SLAB_MAX_SIZE */
+static void *js_slab_alloc(JSRuntime *rt, size_t size)
+{
+    JSSlabClass *sc;
+    int class_idx, block_size;
+    void *ptr;
+
+    class_idx = js_slab_class(size);
+    block_size = (class_idx + 1) << JS_SLAB_SIZE_BITS;
+    sc = &rt->slab_classes[class_idx];
+    ptr = sc->free_list;
+    if (likely(ptr)) {
+        sc->free_list = *(void **)ptr;
+    } else {
+        if (unlikely(sc->ptr >= sc->end)) {
+            if (js_slab_new_page(rt, sc, block_size))
+                return NULL;
+        }
+        ptr = sc->ptr;
+        sc->ptr += block_size;
+    }
+    sc->free_count--;
+    rt->slab_free_size -= block_size;
+    return ptr;
+}
+
+/* 'size' must be the size given to js_slab_alloc() */
+static void js_slab_free(JSRuntime *rt, void *ptr, size_t size)
+{
+    JSSlabClass *sc;
+    int class_idx;
+
+    class_idx = js_slab_class(size);
+    sc = &rt->slab_classes[class_idx];
+    *(void **)ptr = sc->free_list;
+    sc->free_list = ptr;
+    sc->free_count++;
+    rt->slab_free_size += (class_idx + 1) << JS_SLAB_SIZE_BITS;
+}
+
+typedef struct {
+    JSSlabPage *page;
+    int free_count;
+} JSSlabPageInfo;
+
+static int js_slab_page_cmp(const void *a, const void *b, void *opaque)
+{
+    const JSSlabPageInfo *pa = a, *pb = b;
+    if ((uintptr_t)pa->page < (uintptr_t)pb->page)
+        return -1;
+    else
+        return ((uintptr_t)pa->page > (uintptr_t)pb->page);
+}
+
+/* return the index of the page containing 'ptr' */
+static int js_slab_find_page(const JSSlabPageInfo *tab, int count,
+                             const void *ptr)
+{
+    int a, b, m;
+
+    a = 0;
+    b = count - 1;
+    while (a < b) {
+        m = (a + b + 1) >> 1;
+        if ((uintptr_t)tab[m].page <= (uintptr_t)ptr)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return a;
+}
+
+/* Give the pages without allocated blocks back to the system
+   allocator. Only done for the size classes where at least a quarter
+   of the blocks are free because the free lists must be walked. */
+static void js_slab_trim(JSRuntime *rt)
+{
+    JSSlabClass *sc;
+    JSSlabPageInfo *tab;
+    JSSlabPage *pg, **ppg;
+    int class_idx, block_size, n, i, count, freed;
+    void *ptr, **pptr;
+
+    for(class_idx = 0; class_idx < JS_SLAB_CLASS_COUNT; class_idx++) {
+        sc = &rt->slab_classes[class_idx];
+        block_size = (class_idx + 1) << JS_SLAB_SIZE_BITS;
+        n = js_slab_page_blocks(block_size);
+        count = sc->page_count;
+        if (sc->free_count < n || sc->free_count * 4 < count * n)
+            continue;
+        tab = js_malloc_rt(rt, sizeof(tab[0]) * count);
+        if (!tab)
+            return;
+        for(pg = sc->pages, i = 0; pg != NULL; pg = pg->next, i++) {
+            tab[i].page = pg;
+            tab[i].free_count = 0;
+        }
+        rqsort(tab, count, sizeof(tab[0]), js_slab_page_cmp, NULL);
+
+        /* count the free blocks of each page */
+        for(ptr = sc->free_list; ptr != NULL; ptr = *(void **)ptr) {
+            tab[js_slab_find_page(tab, count, ptr)].free_count++;
+        }
+        if (sc->ptr < sc->end) {
+            i = js_slab_find_page(tab, count, sc->end - 1);
+            tab[i].free_count += (sc->end - sc->ptr) / block_size;
+        }
+
+        /* remove the blocks of the empty pages from the free list */
+        pptr = &sc->free_list;
+        while ((ptr = *pptr) != NULL) {
+            if (tab[js_slab_find_page(tab, count, ptr)].free_count == n)
+                *pptr = *(void **)ptr;
+            else
+                pptr = (void **)ptr;
+        }
+        if (sc->ptr < sc->end &&
+            tab[js_slab_find_page(tab, count, sc->end - 1)].free_count == n) {
+            sc->ptr = sc->end = NULL;
+        }
+
+        /* free the empty pages */
+        freed = 0;
+        ppg = &sc->pages;
+        while ((pg = *ppg) != NULL) {
+            if (tab[js_slab_find_page(tab, count, pg)].free_count == n) {
+                *ppg = pg->next;
+                js_free_rt(rt, pg);
+                freed++;
+            } else {
+                ppg = &pg->next;
+            }
+        }
+        sc->page_count -= freed;
+        sc->free_count -= freed * n;
+        rt->slab_free_size -= (size_t)freed * n * block_size;
+        js_free_rt(rt, tab);
+    }
+}
+
+static void js_slab_free_all(JSRuntime *rt)
+{
+    JSSlabClass *sc;
+    JSSlabPage *pg, *pg_next;
+    int class_idx;
+
+    for(class_idx = 0; class_idx < JS_SLAB_CLASS_COUNT; class_idx++) {
+        sc = &rt->slab_classes[class_idx];
+        for(pg = sc->pages; pg != NULL; pg = pg_next) {
+            pg_next = pg->next;
+            js_free_rt(rt, pg);
+        }
+        memset(sc, 0, sizeof(*sc));
+    }
+    rt->slab_free_size = 0;
+}
+
+#else
+
+static void *js_slab_alloc(JSRuntime *rt, size_t size)
+{
+    return js_malloc_rt(rt, size);
+}
+
+static void js_slab_free(JSRuntime *rt, void *ptr, size_t size)
+{
+    js_free_rt(rt, ptr);
+}
+
+static void js_slab_trim(JSRuntime *rt)
+{
+}
+
+static void js_slab_free_all(JSRuntime *rt)
+{
+}
+
+#endif /* !CONFIG_SLAB */
+
+/* Allocation of a block whose size is given again when it is freed:
+   the small blocks come from the slabs. */
+static inline void *js_malloc_sized_rt(JSRuntime *rt, size_t size)
+{
+    if (size <= JS_SLAB_MAX_SIZE)
+        return js_slab_alloc(rt, size);
+    else
+        return js_malloc_rt(rt, size);
+}
+
+static inline void js_free_sized_rt(JSRuntime *rt, void *ptr, size_t size)
+{
+    if (size <= JS_SLAB_MAX_SIZE)
+        js_slab_free(rt, ptr, size);
+    else
+        js_free_rt(rt, ptr);
+}
+
+static void *js_realloc_sized_rt(JSRuntime *rt, void *ptr, size_t old_size,
+                                 size_t new_size)
+{
+    void *new_ptr;
+
+    if (old_size > JS_SLAB_MAX_SIZE && new_size > JS_SLAB_MAX_SIZE)
+        return js_realloc_rt(rt, ptr, new_size);
+    new_ptr = js_malloc_sized_rt(rt, new_size);
+    if (!new_ptr)
+        return NULL;
+    memcpy(new_ptr, ptr, min_int(old_size, new_size));
+    js_free_sized_rt(rt, ptr, old_size);
+    return new_ptr;
+}
+
+/* allocated size minus the free slab blocks */
+static inline size_t js_heap_size(JSRuntime *rt)
+{
+    return rt->malloc_state.malloc_size - rt->slab_free_size;
+}
+
+/* heap growth between two automatic collections, in percent */
+#define GC_GROWTH_DEFAULT 50
+#define GC_GROWTH_MAX     100
+/* bound on the growth allowed above GC_GROWTH_DEFAULT, in bytes, so
+   that large heaps do not bloat under steady churn */
+#define GC_GROWTH_EXTRA_MAX (16 * 1024 * 1024)
+/* minimum allocation between two GC slices, in bytes */
+#define GC_SLICE_ALLOC_MIN (64 * 1024)
+/* minimum number of old objects in a GC slice */
+#define GC_SLICE_OLD_MIN   256
+/* old objects to scan for each promoted object. As with the full
+   collections of the generational mode, the old generation is scanned
+   once when it has grown by 25%. */
+#define GC_SLICE_OLD_RATIO 4
+
+static int64_t js_gc_get_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 static void js_trigger_gc(JSRuntime *rt, size_t size)
 {
     BOOL force_gc;
 #ifdef FORCE_GC_AT_MALLOC
     force_gc = TRUE;
 #else
-    force_gc = ((rt->malloc_state.malloc_size + size) >
-                rt->malloc_gc_threshold);
+    force_gc = ((js_heap_size(rt) + size) > rt->malloc_gc_threshold);
 #endif
     if (force_gc) {
+        JSGCStats *st = &rt->gc_stats;
+        int64_t start_time, pause, elapsed, scanned, freed;
+        size_t heap_size, threshold;
+
 #ifdef DUMP_GC
         printf("GC: size=%" PRIu64 "\n",
                (uint64_t)rt->malloc_state.malloc_size);
 #endif
-        JS_RunGC(rt);
-        rt->malloc_gc_threshold = rt->malloc_state.malloc_size +
-            (rt->malloc_state.malloc_size >> 1);
+        start_time = st->pause_time;
+        scanned = st->objects_scanned;
+        freed = st->objects_freed;
+        if (rt->gc_slice_time > 0) {
+            int64_t old_count;
+            old_count = gc_slice_size(rt, rt->gc_slice_time);
+            /* scanning the live old objects is wasted work: only scan
+               them at the rate at which the old generation grows */
+            if (old_count > rt->gc_slice_debt + GC_SLICE_OLD_MIN)
+                old_count = rt->gc_slice_debt + GC_SLICE_OLD_MIN;
+            gc_collect(rt, old_count);
+        } else if (rt->gc_generational) {
+            gc_collect(rt, 0);
+            /* full collection when the old generation has grown by
+               more than 25% */
+            if (rt->gc_promoted_count > rt->gc_old_count / 4)
+                gc_collect(rt, -1);
+        } else {
+            gc_collect(rt, -1);
+        }
+        pause = st->pause_time - start_time;
+        scanned = st->objects_scanned - scanned;
+        freed = st->objects_freed - freed;
+
+        /* Adapt the heap growth allowed before the next collection.
+           Scanning live objects is wasted work: let the heap grow
+           faster when most objects survive and the GC takes more than
+           5% of the time. When most objects are garbage, the cost of
+           the GC is the cost of freeing them, so go back to the
+           default growth to keep the heap small. */
+        elapsed = js_gc_get_time_us() - rt->gc_end_time;
+        if (freed * 2 < scanned && pause * 20 > elapsed) {
+            rt->gc_growth = min_int(rt->gc_growth * 2, GC_GROWTH_MAX);
+        } else if (freed * 4 > scanned * 3) {
+            rt->gc_growth = max_int(rt->gc_growth / 2, GC_GROWTH_DEFAULT);
+        }
+        rt->gc_end_time = js_gc_get_time_us();
+
+        heap_size = js_heap_size(rt);
+        {
+            size_t extra;
+            extra = heap_size / 100 * (rt->gc_growth - GC_GROWTH_DEFAULT);
+            if (extra > GC_GROWTH_EXTRA_MAX)
+                extra = GC_GROWTH_EXTRA_MAX;
+            threshold = heap_size + heap_size / 100 * GC_GROWTH_DEFAULT +
+                extra;
+        }
+        if (rt->gc_slice_time > 0 && st->pause_time > 0) {
+            /* limit the allocations before the next slice so that
+               collecting the young objects takes about half of the
+               budget */
+            int64_t alloc_size;
+            alloc_size = (int64_t)rt->gc_slice_time * st->bytes_freed /
+                st->pause_time / 2;
+            if (alloc_size < GC_SLICE_ALLOC_MIN)
+                alloc_size = GC_SLICE_ALLOC_MIN;
+            if (threshold - heap_size > alloc_size)
+                threshold = heap_size + alloc_size;
+        }
+        if (threshold < rt->malloc_gc_threshold_min)
+            threshold = rt->malloc_gc_threshold_min;
+        rt->malloc_gc_threshold = threshold;
+        st->threshold = rt->malloc_gc_threshold;
     }
 }
 
@@ -1616,6 +2068,10 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
     }
     rt->malloc_state = ms;
     rt->malloc_gc_threshold = 256 * 1024;
+    rt->malloc_gc_threshold_min = rt->malloc_gc_threshold;
+    rt->gc_growth = GC_GROWTH_DEFAULT;
+    rt->gc_end_time = js_gc_get_time_us();
+    rt->gc_stats.threshold = rt->malloc_gc_threshold;
 
 #ifdef CONFIG_BIGNUM
     bf_context_init(&rt->bf_ctx, js_bf_realloc, rt);
@@ -1627,6 +2083,7 @@ JSRuntime *JS_NewRuntime2(const JSMallocFunctions *mf, void *opaque)
     init_list_head(&rt->context_list);
     init_list_head(&rt->gc_obj_list);
     init_list_head(&rt->gc_zero_ref_count_list);
+    init_list_head(&rt->gc_young_obj_list);
     rt->gc_phase = JS_GC_PHASE_NONE;
     
 #ifdef DUMP_LEAKS
@@ -1774,10 +2231,50 @@ void JS_SetMemoryLimit(JSRuntime *rt, size_t limit)
     rt->malloc_state.malloc_limit = limit;
 }
 
-/* use -1 to disable automatic GC */
+/* use -1 to disable automatic GC. Otherwise the threshold is adjusted
+   after each collection but never goes below 'gc_threshold'. */
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold)
 {
     rt->malloc_gc_threshold = gc_threshold;
+    rt->malloc_gc_threshold_min = gc_threshold;
+    rt->gc_stats.threshold = gc_threshold;
+}
+
+/* When 'budget_us' is not zero, the automatic GC no longer does full
+   collections but collects the young objects and the next slice of the
+   old objects in about 'budget_us' microseconds. The young generation
+   is enabled (see JS_SetGCGenerational()). */
+void JS_SetGCSliceTime(JSRuntime *rt, int budget_us)
+{
+    rt->gc_slice_time = max_int(budget_us, 0);
+    /* the slices are collected with the young objects */
+    if (rt->gc_slice_time > 0)
+        rt->gc_generational = TRUE;
+}
+
+int JS_GetGCSliceTime(JSRuntime *rt)
+{
+    return rt->gc_slice_time;
+}
+
+void JS_GetGCStats(JSRuntime *rt, JSGCStats *s)
+{
+    *s = rt->gc_stats;
+}
+
+/* When enabled, the automatic GC only scans the JS objects allocated
+   since the previous collection. The survivors are promoted to the old
+   generation which is scanned when it has grown enough. JS_RunGC()
+   always scans all the objects.
+   The young generation only limits what a collection scans: its
+   objects come from the slabs like the old ones and are never moved.
+   The strings are not in it because they cannot be part of a cycle,
+   their reference count frees them. */
+void JS_SetGCGenerational(JSRuntime *rt, BOOL enable)
+{
+    if (!enable)
+        gc_promote_young(rt);
+    rt->gc_generational = enable;
 }
 
 #define malloc(s) malloc_is_forbidden(s)
@@ -1873,13 +2370,32 @@ static inline JSAtomStruct *atom_set_free(uint32_t v)
     return (JSAtomStruct *)(((uintptr_t)v << 1) | 1);
 }
 
-/* Note: the string contents are uninitialized */
-static JSString *js_alloc_string_rt(JSRuntime *rt, int max_len, int is_wide_char)
+static inline size_t js_string_alloc_size(int len, int is_wide_char)
+{
+    return sizeof(JSString) + (len << is_wide_char) + 1 - is_wide_char;
+}
+
+/* Note: the string contents are uninitialized. If 'can_resize' is
+   false, the small strings are allocated from the slabs so their
+   length must not be modified. */
+static JSString *js_alloc_string_rt2(JSRuntime *rt, int max_len,
+                                     int is_wide_char, BOOL can_resize)
 {
     JSString *str;
-    str = js_malloc_rt(rt, sizeof(JSString) + (max_len << is_wide_char) + 1 - is_wide_char);
-    if (unlikely(!str))
-        return NULL;
+    size_t size;
+
+    size = js_string_alloc_size(max_len, is_wide_char);
+    if (!can_resize && size <= JS_SLAB_MAX_SIZE) {
+        str = js_slab_alloc(rt, size);
+        if (unlikely(!str))
+            return NULL;
+        str->in_slab = 1;
+    } else {
+        str = js_malloc_rt(rt, size);
+        if (unlikely(!str))
+            return NULL;
+        str->in_slab = 0;
+    }
     str->header.ref_count = 1;
     str->is_wide_char = is_wide_char;
     str->len = max_len;
@@ -1892,10 +2408,16 @@ static JSString *js_alloc_string_rt(JSRuntime *rt, int max_len, int is_wide_char
     return str;
 }
 
-static JSString *js_alloc_string(JSContext *ctx, int max_len, int is_wide_char)
+static JSString *js_alloc_string_rt(JSRuntime *rt, int max_len, int is_wide_char)
+{
+    return js_alloc_string_rt2(rt, max_len, is_wide_char, FALSE);
+}
+
+static JSString *js_alloc_string2(JSContext *ctx, int max_len,
+                                  int is_wide_char, BOOL can_resize)
 {
     JSString *p;
-    p = js_alloc_string_rt(ctx->rt, max_len, is_wide_char);
+    p = js_alloc_string_rt2(ctx->rt, max_len, is_wide_char, can_resize);
     if (unlikely(!p)) {
         JS_ThrowOutOfMemory(ctx);
         return NULL;
@@ -1903,6 +2425,22 @@ static JSString *js_alloc_string(JSContext *ctx, int max_len, int is_wide_char)
     return p;
 }
 
+static JSString *js_alloc_string(JSContext *ctx, int max_len, int is_wide_char)
+{
+    return js_alloc_string2(ctx, max_len, is_wide_char, FALSE);
+}
+
+/* free the memory of a string */
+static void js_free_string_struct(JSRuntime *rt, JSString *str)
+{
+    if (str->in_slab) {
+        js_slab_free(rt, str, js_string_alloc_size(str->len,
+                                                   str->is_wide_char));
+    } else {
+        js_free_rt(rt, str);
+    }
+}
+
 /* same as JS_FreeValueRT() but faster */
 static inline void js_free_string(JSRuntime *rt, JSString *str)
 {
@@ -1913,7 +2451,7 @@ static inline void js_free_string(JSRuntime *rt, JSString *str)
 #ifdef DUMP_LEAKS
             list_del(&str->link);
 #endif
-            js_free_rt(rt, str);
+            js_free_string_struct(rt, str);
         }
     }
 }
@@ -2060,9 +2598,13 @@ void JS_FreeRuntime(JSRuntime *rt)
 #ifdef DUMP_LEAKS
             list_del(&p->link);
 #endif
-            js_free_rt(rt, p);
+            if (i >= JS_ATOM_END)
+                js_free_string_struct(rt, p);
         }
     }
+    /* the block of the predefined atoms */
+    if (rt->atom_size != 0)
+        js_free_rt(rt, rt->atom_array[JS_ATOM_NULL]);
     js_free_rt(rt, rt->atom_array);
     js_free_rt(rt, rt->atom_hash);
     js_free_rt(rt, rt->shape_hash);
@@ -2089,11 +2631,16 @@ void JS_FreeRuntime(JSRuntime *rt)
                 printf("\n");
             }
             list_del(&str->link);
-            js_free_rt(rt, str);
+            js_free_string_struct(rt, str);
         }
         if (rt->rt_info)
             printf("\n");
     }
+#endif
+
+    js_slab_free_all(rt);
+
+#ifdef DUMP_LEAKS
     {
         JSMallocState *s = &rt->malloc_state;
         if (s->malloc_count > 1) {
@@ -2141,12 +2688,100 @@ JSContext *JS_NewContextRaw(JSRuntime *rt)
     ctx->array_ctor = JS_NULL;
     ctx->regexp_ctor = JS_NULL;
     ctx->promise_ctor = JS_NULL;
+    ctx->lazy_global_obj = JS_UNDEFINED;
     init_list_head(&ctx->loaded_modules);
 
     JS_AddIntrinsicBasicObjects(ctx);
     return ctx;
 }
 
+typedef struct JSLazyIntrinsic {
+    void (*init)(JSContext *ctx);
+    /* the prototypes it creates */
+    uint16_t first_class_id, last_class_id;
+    /* its global bindings */
+    uint16_t first_atom, last_atom;
+} JSLazyIntrinsic;
+
+static const JSLazyIntrinsic js_lazy_intrinsics[JS_LAZY_INTRINSIC_COUNT] = {
+    { JS_AddIntrinsicDate, JS_CLASS_DATE, JS_CLASS_DATE,
+      JS_ATOM_Date, JS_ATOM_Date },
+    { JS_AddIntrinsicMapSet, JS_CLASS_MAP, JS_CLASS_SET_ITERATOR,
+      JS_ATOM_Map, JS_ATOM_WeakSet },
+    { js_add_intrinsic_typed_arrays, JS_CLASS_ARRAY_BUFFER, JS_CLASS_DATAVIEW,
+      JS_ATOM_ArrayBuffer, JS_ATOM_DataView },
+};
+
+/* define the global bindings of a lazy intrinsic as autoinit
+   properties. The intrinsic is created when one of them is read or
+   when the engine needs one of its prototypes. */
+static void js_add_lazy_intrinsic(JSContext *ctx, JSLazyIntrinsicEnum id)
+{
+    const JSLazyIntrinsic *li = &js_lazy_intrinsics[id];
+    JSAtom atom;
+
+    ctx->lazy_intrinsics |= 1 << id;
+    for(atom = li->first_atom; atom <= li->last_atom; atom++) {
+        JS_DefineAutoInitProperty(ctx, ctx->global_obj, atom,
+                                  JS_AUTOINIT_ID_INTRINSIC,
+                                  (void *)(uintptr_t)id,
+                                  JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE);
+    }
+}
+
+static int js_init_lazy_intrinsic(JSContext *ctx, JSLazyIntrinsicEnum id)
+{
+    JSValue global_obj;
+
+    if (!(ctx->lazy_intrinsics & (1 << id)))
+        return 0;
+    if (JS_IsUndefined(ctx->lazy_global_obj)) {
+        ctx->lazy_global_obj = JS_NewObjectProto(ctx, JS_NULL);
+        if (JS_IsException(ctx->lazy_global_obj)) {
+            ctx->lazy_global_obj = JS_UNDEFINED;
+            return -1;
+        }
+    }
+    ctx->lazy_intrinsics &= ~(1 << id);
+    /* the constructors are defined in lazy_global_obj because the
+       global object may be in the middle of an autoinit. Both objects
+       stay referenced in case the GC runs meanwhile. */
+    global_obj = ctx->global_obj;
+    ctx->global_obj = JS_DupValue(ctx, ctx->lazy_global_obj);
+    js_lazy_intrinsics[id].init(ctx);
+    JS_FreeValue(ctx, ctx->global_obj);
+    ctx->global_obj = global_obj;
+    return 0;
+}
+
+static JSValue js_lazy_intrinsic_autoinit(JSContext *ctx, JSObject *p,
+                                          JSAtom atom, void *opaque)
+{
+    if (js_init_lazy_intrinsic(ctx, (uintptr_t)opaque))
+        return JS_EXCEPTION;
+    return JS_GetProperty(ctx, ctx->lazy_global_obj, atom);
+}
+
+/* return the prototype of 'class_id' in 'ctx', creating the lazy
+   intrinsic it belongs to if needed */
+static JSValueConst js_get_class_proto(JSContext *ctx, JSClassID class_id)
+{
+    int id;
+
+    if (unlikely(JS_IsNull(ctx->class_proto[class_id])) &&
+        ctx->lazy_intrinsics) {
+        for(id = 0; id < JS_LAZY_INTRINSIC_COUNT; id++) {
+            const JSLazyIntrinsic *li = &js_lazy_intrinsics[id];
+            if (class_id >= li->first_class_id &&
+                class_id <= li->last_class_id) {
+                js_init_lazy_intrinsic(ctx, id);
+                break;
+            }
+        }
+    }
+    return ctx->class_proto[class_id];
+}
+
 JSContext *JS_NewContext(JSRuntime *rt)
 {
     JSContext *ctx;
@@ -2156,14 +2791,21 @@ JSContext *JS_NewContext(JSRuntime *rt)
         return NULL;
 
     JS_AddIntrinsicBaseObjects(ctx);
-    JS_AddIntrinsicDate(ctx);
+    js_add_lazy_intrinsic(ctx, JS_LAZY_INTRINSIC_DATE);
+#ifndef CONFIG_NO_EVAL
     JS_AddIntrinsicEval(ctx);
+#endif
     JS_AddIntrinsicStringNormalize(ctx);
     JS_AddIntrinsicRegExp(ctx);
     JS_AddIntrinsicJSON(ctx);
+#ifndef CONFIG_NO_PROXY
     JS_AddIntrinsicProxy(ctx);
-    JS_AddIntrinsicMapSet(ctx);
-    JS_AddIntrinsicTypedArrays(ctx);
+#endif
+    js_add_lazy_intrinsic(ctx, JS_LAZY_INTRINSIC_MAP_SET);
+    js_add_lazy_intrinsic(ctx, JS_LAZY_INTRINSIC_TYPED_ARRAYS);
+#ifdef CONFIG_ATOMICS
+    JS_AddIntrinsicAtomics(ctx);
+#endif
     JS_AddIntrinsicPromise(ctx);
 #ifdef CONFIG_BIGNUM
     JS_AddIntrinsicBigInt(ctx);
@@ -2202,7 +2844,7 @@ JSValue JS_GetClassProto(JSContext *ctx, JSClassID class_id)
 {
     JSRuntime *rt = ctx->rt;
     assert(class_id < rt->class_count);
-    return JS_DupValue(ctx, ctx->class_proto[class_id]);
+    return JS_DupValue(ctx, js_get_class_proto(ctx, class_id));
 }
 
 typedef enum JSFreeModuleEnum {
@@ -2247,6 +2889,7 @@ static void JS_MarkContext(JSRuntime *rt, JSContext *ctx,
 
     JS_MarkValue(rt, ctx->global_obj, mark_func);
     JS_MarkValue(rt, ctx->global_var_obj, mark_func);
+    JS_MarkValue(rt, ctx->lazy_global_obj, mark_func);
 
     JS_MarkValue(rt, ctx->throw_type_error, mark_func);
     JS_MarkValue(rt, ctx->eval_obj, mark_func);
@@ -2268,6 +2911,14 @@ static void JS_MarkContext(JSRuntime *rt, JSContext *ctx,
 
     if (ctx->array_shape)
         mark_func(rt, &ctx->array_shape->header);
+    for(i = 0; i < countof(ctx->json_shape_cache); i++) {
+        if (ctx->json_shape_cache[i])
+            mark_func(rt, &ctx->json_shape_cache[i]->header);
+    }
+    for(i = 0; i < countof(ctx->json_keys_cache); i++) {
+        if (ctx->json_keys_cache[i])
+            mark_func(rt, &ctx->json_keys_cache[i]->shape->header);
+    }
 }
 
 void JS_FreeContext(JSContext *ctx)
@@ -2291,6 +2942,7 @@ void JS_FreeContext(JSContext *ctx)
         JSGCObjectHeader *p;
         printf("JSObjects: {\n");
         JS_DumpObjectHeader(ctx->rt);
+        gc_promote_young(rt);
         list_for_each(el, &rt->gc_obj_list) {
             p = list_entry(el, JSGCObjectHeader, link);
             JS_DumpGCObject(rt, p);
@@ -2310,6 +2962,7 @@ void JS_FreeContext(JSContext *ctx)
 
     JS_FreeValue(ctx, ctx->global_obj);
     JS_FreeValue(ctx, ctx->global_var_obj);
+    JS_FreeValue(ctx, ctx->lazy_global_obj);
 
     JS_FreeValue(ctx, ctx->throw_type_error);
     JS_FreeValue(ctx, ctx->eval_obj);
@@ -2331,6 +2984,15 @@ void JS_FreeContext(JSContext *ctx)
     JS_FreeValue(ctx, ctx->function_proto);
 
     js_free_shape_null(ctx->rt, ctx->array_shape);
+    for(i = 0; i < countof(ctx->json_key_cache); i++) {
+        JS_FreeAtom(ctx, ctx->json_key_cache[i]);
+    }
+    for(i = 0; i < countof(ctx->json_shape_cache); i++) {
+        js_free_shape_null(ctx->rt, ctx->json_shape_cache[i]);
+    }
+    for(i = 0; i < countof(ctx->json_keys_cache); i++) {
+        json_free_shape_keys(ctx->rt, ctx->json_keys_cache[i]);
+    }
 
     list_del(&ctx->link);
     remove_gc_object(&ctx->header);
@@ -2582,32 +3244,99 @@ static int JS_ResizeAtomHash(JSRuntime *rt, int new_hash_size)
     return 0;
 }
 
+/* room for the atoms of a context with its intrinsic objects, so that
+   the atom array and hash table are not resized while it is created */
+#define JS_ATOM_INIT_SIZE      711
+#define JS_ATOM_INIT_HASH_SIZE 512
+
+/* keep the next string of the block aligned */
+#define JS_ATOM_INIT_ALIGN 8
+
+/* The predefined atoms are constant: their strings are laid out in a
+   single block, starting with JS_ATOM_NULL, which is freed with the
+   runtime. */
 static int JS_InitAtoms(JSRuntime *rt)
 {
     int i, len, atom_type;
     const char *p;
+    JSAtomStruct *str;
+    uint8_t *ptr;
+    uint32_t h, h1;
+    size_t size;
 
     rt->atom_hash_size = 0;
     rt->atom_hash = NULL;
     rt->atom_count = 0;
     rt->atom_size = 0;
     rt->atom_free_index = 0;
-    if (JS_ResizeAtomHash(rt, 256))     /* there are at least 195 predefined atoms */
+    if (JS_ResizeAtomHash(rt, JS_ATOM_INIT_HASH_SIZE))
         return -1;
 
+    size = JS_ATOM_END * (sizeof(JSString) + JS_ATOM_INIT_ALIGN) +
+        sizeof(js_atom_init);
+    ptr = js_malloc_rt(rt, size);
+    if (!ptr)
+        return -1;
+    rt->atom_array = js_malloc_rt(rt, sizeof(rt->atom_array[0]) *
+                                  JS_ATOM_INIT_SIZE);
+    if (!rt->atom_array) {
+        js_free_rt(rt, ptr);
+        return -1;
+    }
+    rt->atom_size = JS_ATOM_INIT_SIZE;
+
     p = js_atom_init;
-    for(i = 1; i < JS_ATOM_END; i++) {
-        if (i == JS_ATOM_Private_brand)
-            atom_type = JS_ATOM_TYPE_PRIVATE;
-        else if (i >= JS_ATOM_Symbol_toPrimitive)
+    for(i = 0; i < JS_ATOM_END; i++) {
+        if (i == JS_ATOM_NULL) {
+            len = 0;
             atom_type = JS_ATOM_TYPE_SYMBOL;
-        else
-            atom_type = JS_ATOM_TYPE_STRING;
-        len = strlen(p);
-        if (__JS_NewAtomInit(rt, p, len, atom_type) == JS_ATOM_NULL)
-            return -1;
-        p = p + len + 1;
+            h = 0;
+        } else {
+            len = strlen(p);
+            if (i == JS_ATOM_Private_brand) {
+                atom_type = JS_ATOM_TYPE_SYMBOL;
+                h = JS_ATOM_HASH_PRIVATE;
+            } else if (i >= JS_ATOM_Symbol_toPrimitive) {
+                atom_type = JS_ATOM_TYPE_SYMBOL;
+                h = JS_ATOM_HASH_SYMBOL;
+            } else {
+                atom_type = JS_ATOM_TYPE_STRING;
+                h = js_atom_init_hash[i];
+            }
+        }
+        str = (JSAtomStruct *)ptr;
+        str->header.ref_count = 1;
+        str->len = len;
+        str->is_wide_char = 0;
+        str->hash = h;
+        str->in_slab = 0;
+        str->atom_type = atom_type;
+        if (atom_type == JS_ATOM_TYPE_SYMBOL) {
+            str->hash_next = i;   /* atom_index */
+        } else {
+            h1 = h & (rt->atom_hash_size - 1);
+            str->hash_next = rt->atom_hash[h1];
+            rt->atom_hash[h1] = i;
+        }
+#ifdef DUMP_LEAKS
+        list_add_tail(&str->link, &rt->string_list);
+#endif
+        if (i != JS_ATOM_NULL) {
+            memcpy(str->u.str8, p, len + 1);
+            p += len + 1;
+        } else {
+            str->u.str8[0] = '\0';
+        }
+        rt->atom_array[i] = str;
+        ptr += (js_string_alloc_size(len, 0) + JS_ATOM_INIT_ALIGN - 1) &
+            ~(JS_ATOM_INIT_ALIGN - 1);
     }
+    rt->atom_count = JS_ATOM_END;
+
+    rt->atom_free_index = JS_ATOM_END;
+    for(i = JS_ATOM_END; i < rt->atom_size - 1; i++)
+        rt->atom_array[i] = atom_set_free(i + 1);
+    rt->atom_array[i] = atom_set_free(0);
     return 0;
 }
 
@@ -2741,33 +3470,16 @@ static JSAtom __JS_NewAtom(JSRuntime *rt, JSString *str, int atom_type)
 
         /* alloc new with size progression 3/2:
            4 6 9 13 19 28 42 63 94 141 211 316 474 711 1066 1599 2398 3597 5395 8092
-           preallocating space for predefined atoms (at least 195).
+           JS_InitAtoms() allocates the first JS_ATOM_INIT_SIZE entries.
          */
-        new_size = max_int(211, rt->atom_size * 3 / 2);
+        new_size = rt->atom_size * 3 / 2;
         if (new_size > JS_ATOM_MAX)
             goto fail;
         /* XXX: should use realloc2 to use slack space */
         new_array = js_realloc_rt(rt, rt->atom_array, sizeof(*new_array) * new_size);
         if (!new_array)
             goto fail;
-        /* Note: the atom 0 is not used */
         start = rt->atom_size;
-        if (start == 0) {
-            /* JS_ATOM_NULL entry */
-            p = js_mallocz_rt(rt, sizeof(JSAtomStruct));
-            if (!p) {
-                js_free_rt(rt, new_array);
-                goto fail;
-            }
-            p->header.ref_count = 1;  /* not refcounted */
-            p->atom_type = JS_ATOM_TYPE_SYMBOL;
-#ifdef DUMP_LEAKS
-            list_add_tail(&p->link, &rt->string_list);
-#endif
-            new_array[0] = p;
-            rt->atom_count++;
-            start = 1;
-        }
         rt->atom_size = new_size;
         rt->atom_array = new_array;
         rt->atom_free_index = start;
@@ -2786,31 +3498,18 @@ static JSAtom __JS_NewAtom(JSRuntime *rt, JSString *str, int atom_type)
             p = str;
             p->atom_type = atom_type;
         } else {
-            p = js_malloc_rt(rt, sizeof(JSString) +
-                             (str->len << str->is_wide_char) +
-                             1 - str->is_wide_char);
+            p = js_alloc_string_rt(rt, str->len, str->is_wide_char);
             if (unlikely(!p))
                 goto fail;
-            p->header.ref_count = 1;
-            p->is_wide_char = str->is_wide_char;
-            p->len = str->len;
-#ifdef DUMP_LEAKS
-            list_add_tail(&p->link, &rt->string_list);
-#endif
             memcpy(p->u.str8, str->u.str8, (str->len << str->is_wide_char) +
                    1 - str->is_wide_char);
             js_free_string(rt, str);
         }
     } else {
-        p = js_malloc_rt(rt, sizeof(JSAtomStruct)); /* empty wide string */
+        /* empty wide string: hack to represent NULL as a JSString */
+        p = js_alloc_string_rt(rt, 0, 1);
         if (!p)
             return JS_ATOM_NULL;
-        p->header.ref_count = 1;
-        p->is_wide_char = 1;    /* Hack to represent NULL as a JSString */
-        p->len = 0;
-#ifdef DUMP_LEAKS
-        list_add_tail(&p->link, &rt->string_list);
-#endif
     }
 
     /* use an already free entry */
@@ -2919,7 +3618,7 @@ static void JS_FreeAtomStruct(JSRuntime *rt, JSAtomStruct *p)
 #ifdef DUMP_LEAKS
     list_del(&p->link);
 #endif
-    js_free_rt(rt, p);
+    js_free_string_struct(rt, p);
     rt->atom_count--;
     assert(rt->atom_count >= 0);
 }
@@ -3542,7 +4241,7 @@ static int string_buffer_init2(JSContext *ctx, StringBuffer *s, int size,
     s->len = 0;
     s->is_wide_char = is_wide;
     s->error_status = 0;
-    s->str = js_alloc_string(ctx, size, is_wide);
+    s->str = js_alloc_string2(ctx, size, is_wide, TRUE);
     if (unlikely(!s->str)) {
         s->size = 0;
         return s->error_status = -1;
@@ -3840,7 +4539,20 @@ static JSValue string_buffer_end(StringBuffer *s)
         s->str = NULL;
         return JS_AtomToString(s->ctx, JS_ATOM_empty_string);
     }
-    if (s->len < s->size) {
+    if (js_string_alloc_size(s->len, s->is_wide_char) <= JS_SLAB_MAX_SIZE) {
+        /* copy the small strings to the slabs. Keep the buffer if
+           the allocation fails. */
+        str = js_alloc_string_rt(s->ctx->rt, s->len, s->is_wide_char);
+        if (str) {
+            memcpy(str->u.str8, s->str->u.str8, s->len << s->is_wide_char);
+            if (!s->is_wide_char)
+                str->u.str8[s->len] = 0;
+            js_free(s->ctx, s->str);
+            s->str = NULL;
+            return JS_MKPTR(JS_TAG_STRING, str);
+        }
+        str = s->str;
+    } else if (s->len < s->size) {
         /* smaller size so js_realloc should not fail, but OK if it does */
         /* XXX: should add some slack to avoid unnecessary calls */
         /* XXX: might need to use malloc+free to ensure smaller size */
@@ -3990,28 +4702,28 @@ const char *JS_ToCStringLen2(JSContext *ctx, size_t *plen, JSValueConst val1, BO
     len = str->len;
     if (!str->is_wide_char) {
         const uint8_t *src = str->u.str8;
-        int count;
+        int count, ascii_len;
 
-        /* count the number of non-ASCII characters */
-        /* Scanning the whole string is required for ASCII strings,
-           and computing the number of non-ASCII bytes is less expensive
-           than testing each byte, hence this method is faster for ASCII
-           strings, which is the most common case.
-         */
-        count = 0;
-        for (pos = 0; pos < len; pos++) {
-            count += src[pos] >> 7;
-        }
-        if (count == 0) {
+        /* ASCII strings, which are the most common case, are
+           returned as is. Otherwise the ASCII prefix is copied in one
+           go and the non-ASCII bytes are counted from its end. */
+        ascii_len = str8_find_non_ascii(src, len);
+        if (ascii_len == len) {
             if (plen)
                 *plen = len;
             return (const char *)src;
         }
-        str_new = js_alloc_string(ctx, len + count, 0);
+        count = 0;
+        for (pos = ascii_len; pos < len; pos++) {
+            count += src[pos] >> 7;
+        }
+        str_new = js_alloc_string2(ctx, len + count, 0, TRUE);
         if (!str_new)
             goto fail;
         q = str_new->u.str8;
-        for (pos = 0; pos < len; pos++) {
+        memcpy(q, src, ascii_len);
+        q += ascii_len;
+        for (pos = ascii_len; pos < len; pos++) {
             c = src[pos];
             if (c < 0x80) {
                 *q++ = c;
@@ -4025,7 +4737,7 @@ const char *JS_ToCStringLen2(JSContext *ctx, size_t *plen, JSValueConst val1, BO
         /* Allocate 3 bytes per 16 bit code point. Surrogate pairs may
            produce 4 bytes but use 2 code points.
          */
-        str_new = js_alloc_string(ctx, len * 3, 0);
+        str_new = js_alloc_string2(ctx, len * 3, 0, TRUE);
         if (!str_new)
             goto fail;
         q = str_new->u.str8;
@@ -4091,12 +4803,10 @@ static int memcmp16_8(const uint16_t *src1, const uint8_t *src2, int len)
 
 static int memcmp16(const uint16_t *src1, const uint16_t *src2, int len)
 {
-    int c, i;
-    for(i = 0; i < len; i++) {
-        c = src1[i] - src2[i];
-        if (c != 0)
-            return c;
-    }
+    int i;
+    i = str16_mismatch(src1, src2, len);
+    if (i < len)
+        return src1[i] - src2[i];
     return 0;
 }
 
@@ -4149,20 +4859,66 @@ static void copy_str16(uint16_t *dst, const JSString *p, int offset, int len)
     }
 }
 
+/* Non atom strings that were built by concatenation may have spare room
+   at the end so that further appends do not have to copy them. The
+   capacity in characters is kept in the otherwise unused 'hash_next'
+   field. 0 means no spare room beyond what the allocator may provide. */
+static inline uint32_t js_string_capacity(const JSString *p)
+{
+    return p->atom_type ? 0 : p->hash_next;
+}
+
+/* Append p2 to p1 in place if nothing else references p1 and it has room
+   for it. Return TRUE if done. */
+static BOOL js_string_append_in_place(JSContext *ctx, JSString *p1,
+                                      const JSString *p2)
+{
+    uint32_t len;
+
+    len = p1->len + p2->len;
+    if (p1->header.ref_count != 1 || p1->atom_type != 0 ||
+        p1->is_wide_char != p2->is_wide_char || len > JS_STRING_LEN_MAX)
+        return FALSE;
+    if (len > js_string_capacity(p1) &&
+        (p1->in_slab ||
+         js_malloc_usable_size(ctx, p1) < js_string_alloc_size(len, p1->is_wide_char)))
+        return FALSE;
+
+    if (p1->is_wide_char) {
+        memcpy(p1->u.str16 + p1->len, p2->u.str16, p2->len << 1);
+        p1->len = len;
+    } else {
+        memcpy(p1->u.str8 + p1->len, p2->u.str8, p2->len);
+        p1->len = len;
+        p1->u.str8[len] = '\0';
+    }
+    return TRUE;
+}
+
+/* If 'grow' is true, the result is likely to be appended to again (it
+   replaces an unshared string), so some room is reserved at the end to
+   make repeated appends amortized O(1). */
 static JSValue JS_ConcatString1(JSContext *ctx,
-                                const JSString *p1, const JSString *p2)
+                                const JSString *p1, const JSString *p2,
+                                BOOL grow)
 {
     JSString *p;
-    uint32_t len;
+    uint32_t len, size;
     int is_wide_char;
 
     len = p1->len + p2->len;
     if (len > JS_STRING_LEN_MAX)
         return JS_ThrowInternalError(ctx, "string too long");
+    size = len;
+    if (grow)
+        size = min_uint32(len + (len >> 1) + 16, JS_STRING_LEN_MAX);
     is_wide_char = p1->is_wide_char | p2->is_wide_char;
-    p = js_alloc_string(ctx, len, is_wide_char);
+    p = js_alloc_string2(ctx, size, is_wide_char, grow);
     if (!p)
         return JS_EXCEPTION;
+    p->len = len;
+    if (grow)
+        p->hash_next = size;
     if (!is_wide_char) {
         memcpy(p->u.str8, p1->u.str8, p1->len);
         memcpy(p->u.str8 + p1->len, p2->u.str8, p2->len);
@@ -4199,30 +4955,54 @@ static JSValue JS_ConcatString(JSContext *ctx, JSValue op1, JSValue op2)
     p2 = JS_VALUE_GET_STRING(op2);
 
     /* XXX: could also check if p1 is empty */
-    if (p2->len == 0) {
-        goto ret_op1;
-    }
-    if (p1->header.ref_count == 1 && p1->is_wide_char == p2->is_wide_char
-    &&  js_malloc_usable_size(ctx, p1) >= sizeof(*p1) + ((p1->len + p2->len) << p2->is_wide_char) + 1 - p1->is_wide_char) {
-        /* Concatenate in place in available space at the end of p1 */
-        if (p1->is_wide_char) {
-            memcpy(p1->u.str16 + p1->len, p2->u.str16, p2->len << 1);
-            p1->len += p2->len;
-        } else {
-            memcpy(p1->u.str8 + p1->len, p2->u.str8, p2->len);
-            p1->len += p2->len;
-            p1->u.str8[p1->len] = '\0';
-        }
-    ret_op1:
+    if (p2->len == 0 || js_string_append_in_place(ctx, p1, p2)) {
         JS_FreeValue(ctx, op2);
         return op1;
     }
-    ret = JS_ConcatString1(ctx, p1, p2);
+    ret = JS_ConcatString1(ctx, p1, p2, p1->header.ref_count == 1);
     JS_FreeValue(ctx, op1);
     JS_FreeValue(ctx, op2);
     return ret;
 }
 
+/* Append op2 to the string in *pv, as done by 'a += b' on a local
+   variable. The variable's own reference is not counted, so a string only
+   it holds can be grown in place. *pv is left untouched on exception. */
+static int js_concat_string_var(JSContext *ctx, JSValue *pv, JSValue op2)
+{
+    JSString *p1, *p2;
+    JSValue ret;
+
+    if (unlikely(JS_VALUE_GET_TAG(*pv) != JS_TAG_STRING)) {
+        /* the variable was modified by a valueOf() or toString() call */
+        ret = JS_ConcatString(ctx, JS_DupValue(ctx, *pv), op2);
+        if (JS_IsException(ret))
+            return -1;
+        set_value(ctx, pv, ret);
+        return 0;
+    }
+    if (unlikely(JS_VALUE_GET_TAG(op2) != JS_TAG_STRING)) {
+        op2 = JS_ToStringFree(ctx, op2);
+        if (JS_IsException(op2))
+            return -1;
+    }
+    p1 = JS_VALUE_GET_STRING(*pv);
+    p2 = JS_VALUE_GET_STRING(op2);
+
+    if (p2->len == 0 || js_string_append_in_place(ctx, p1, p2)) {
+        JS_FreeValue(ctx, op2);
+        return 0;
+    }
+    /* the result replaces the variable, so it is likely to be appended
+       to again even if the old value is shared */
+    ret = JS_ConcatString1(ctx, p1, p2, TRUE);
+    JS_FreeValue(ctx, op2);
+    if (JS_IsException(ret))
+        return -1;
+    set_value(ctx, pv, ret);
+    return 0;
+}
+
 /* Shape support */
 
 static inline size_t get_shape_size(size_t hash_size, size_t prop_size)
@@ -4246,6 +5026,22 @@ static inline void *get_alloc_from_shape(JSShape *sh)
     return prop_hash_end(sh) - ((intptr_t)sh->prop_hash_mask + 1);
 }
 
+/* the small shapes are allocated from the slabs */
+static void *js_alloc_shape(JSContext *ctx, size_t hash_size, size_t prop_size)
+{
+    void *sh_alloc;
+    sh_alloc = js_malloc_sized_rt(ctx->rt, get_shape_size(hash_size, prop_size));
+    if (unlikely(!sh_alloc))
+        JS_ThrowOutOfMemory(ctx);
+    return sh_alloc;
+}
+
+static void js_free_shape_alloc(JSRuntime *rt, JSShape *sh)
+{
+    js_free_sized_rt(rt, get_alloc_from_shape(sh),
+                     get_shape_size(sh->prop_hash_mask + 1, sh->prop_size));
+}
+
 static inline JSShapeProperty *get_shape_prop(JSShape *sh)
 {
     return sh->prop;
@@ -4345,7 +5141,7 @@ static no_inline JSShape *js_new_shape2(JSContext *ctx, JSObject *proto,
         resize_shape_hash(rt, rt->shape_hash_bits + 1);
     }
 
-    sh_alloc = js_malloc(ctx, get_shape_size(hash_size, prop_size));
+    sh_alloc = js_alloc_shape(ctx, hash_size, prop_size);
     if (!sh_alloc)
         return NULL;
     sh = get_shape_from_alloc(sh_alloc, hash_size);
@@ -4387,7 +5183,7 @@ static JSShape *js_clone_shape(JSContext *ctx, JSShape *sh1)
 
     hash_size = sh1->prop_hash_mask + 1;
     size = get_shape_size(hash_size, sh1->prop_size);
-    sh_alloc = js_malloc(ctx, size);
+    sh_alloc = js_alloc_shape(ctx, hash_size, sh1->prop_size);
     if (!sh_alloc)
         return NULL;
     sh_alloc1 = get_alloc_from_shape(sh1);
@@ -4428,7 +5224,7 @@ static void js_free_shape0(JSRuntime *rt, JSShape *sh)
         pr++;
     }
     remove_gc_object(&sh->header);
-    js_free_rt(rt, get_alloc_from_shape(sh));
+    js_free_shape_alloc(rt, sh);
 }
 
 static void js_free_shape(JSRuntime *rt, JSShape *sh)
@@ -4472,7 +5268,7 @@ static no_inline int resize_properties(JSContext *ctx, JSShape **psh,
         JSShape *old_sh;
         /* resize the hash table and the properties */
         old_sh = sh;
-        sh_alloc = js_malloc(ctx, get_shape_size(new_hash_size, new_size));
+        sh_alloc = js_alloc_shape(ctx, new_hash_size, new_size);
         if (!sh_alloc)
             return -1;
         sh = get_shape_from_alloc(sh_alloc, new_hash_size);
@@ -4492,15 +5288,17 @@ static no_inline int resize_properties(JSContext *ctx, JSShape **psh,
                 prop_hash_end(sh)[-h - 1] = i + 1;
             }
         }
-        js_free(ctx, get_alloc_from_shape(old_sh));
+        js_free_shape_alloc(ctx->rt, old_sh);
     } else {
         /* only resize the properties */
         list_del(&sh->header.link);
-        sh_alloc = js_realloc(ctx, get_alloc_from_shape(sh),
-                              get_shape_size(new_hash_size, new_size));
+        sh_alloc = js_realloc_sized_rt(ctx->rt, get_alloc_from_shape(sh),
+                                       get_shape_size(new_hash_size, sh->prop_size),
+                                       get_shape_size(new_hash_size, new_size));
         if (unlikely(!sh_alloc)) {
             /* insert again in the GC list */
             list_add_tail(&sh->header.link, &ctx->rt->gc_obj_list);
+            JS_ThrowOutOfMemory(ctx);
             return -1;
         }
         sh = get_shape_from_alloc(sh_alloc, new_hash_size);
@@ -4535,7 +5333,7 @@ static int compact_properties(JSContext *ctx, JSObject *p)
 
     /* resize the hash table and the properties */
     old_sh = sh;
-    sh_alloc = js_malloc(ctx, get_shape_size(new_hash_size, new_size));
+    sh_alloc = js_alloc_shape(ctx, new_hash_size, new_size);
     if (!sh_alloc)
         return -1;
     sh = get_shape_from_alloc(sh_alloc, new_hash_size);
@@ -4570,7 +5368,7 @@ static int compact_properties(JSContext *ctx, JSObject *p)
     sh->prop_count = j;
 
     p->shape = sh;
-    js_free(ctx, get_alloc_from_shape(old_sh));
+    js_free_shape_alloc(ctx->rt, old_sh);
     
     /* reduce the size of the object properties */
     new_prop = js_realloc(ctx, p->prop, sizeof(new_prop[0]) * new_size);
@@ -4708,6 +5506,7 @@ static __maybe_unused void JS_DumpShapes(JSRuntime *rt)
         }
     }
     /* dump non-hashed shapes */
+    gc_promote_young(rt);
     list_for_each(el, &rt->gc_obj_list) {
         gp = list_entry(el, JSGCObjectHeader, link);
         if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
@@ -4725,9 +5524,11 @@ static JSValue JS_NewObjectFromShape(JSContext *ctx, JSShape *sh, JSClassID clas
     JSObject *p;
 
     js_trigger_gc(ctx->rt, sizeof(JSObject));
-    p = js_malloc(ctx, sizeof(JSObject));
-    if (unlikely(!p))
+    p = js_slab_alloc(ctx->rt, sizeof(JSObject));
+    if (unlikely(!p)) {
+        JS_ThrowOutOfMemory(ctx);
         goto fail;
+    }
     p->class_id = class_id;
     p->extensible = TRUE;
     p->free_mark = 0;
@@ -4742,7 +5543,7 @@ static JSValue JS_NewObjectFromShape(JSContext *ctx, JSShape *sh, JSClassID clas
     p->shape = sh;
     p->prop = js_malloc(ctx, sizeof(JSProperty) * sh->prop_size);
     if (unlikely(!p->prop)) {
-        js_free(ctx, p);
+        js_slab_free(ctx->rt, p, sizeof(JSObject));
     fail:
         js_free_shape(ctx->rt, sh);
         return JS_EXCEPTION;
@@ -4907,7 +5708,8 @@ static int JS_SetObjectData(JSContext *ctx, JSValueConst obj, JSValue val)
 
 JSValue JS_NewObjectClass(JSContext *ctx, int class_id)
 {
-    return JS_NewObjectProtoClass(ctx, ctx->class_proto[class_id], class_id);
+    return JS_NewObjectProtoClass(ctx, js_get_class_proto(ctx, class_id),
+                                  class_id);
 }
 
 JSValue JS_NewObjectProto(JSContext *ctx, JSValueConst proto)
@@ -5435,7 +6237,7 @@ static void free_object(JSRuntime *rt, JSObject *p)
     if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES && p->header.ref_count != 0) {
         list_add_tail(&p->header.link, &rt->gc_zero_ref_count_list);
     } else {
-        js_free_rt(rt, p);
+        js_slab_free(rt, p, sizeof(JSObject));
     }
 }
 
@@ -5497,7 +6299,7 @@ void __JS_FreeValueRT(JSRuntime *rt, JSValue v)
 #ifdef DUMP_LEAKS
                 list_del(&p->link);
 #endif
-                js_free_rt(rt, p);
+                js_free_string_struct(rt, p);
             }
         }
         break;
@@ -5511,6 +6313,11 @@ void __JS_FreeValueRT(JSRuntime *rt, JSValue v)
                 if (rt->gc_phase == JS_GC_PHASE_NONE) {
                     free_zero_refcount(rt);
                 }
+            } else if (p->mark == 0) {
+                /* object outside of the collected generation which was
+                   only referenced by the cycles: free it with them */
+                list_del(&p->link);
+                list_add_tail(&p->link, &rt->tmp_obj_list);
             }
         }
         break;
@@ -5553,12 +6360,20 @@ void __JS_FreeValue(JSContext *ctx, JSValue v)
 
 /* garbage collection */
 
+/* mark value of the young objects outside of the GC */
+#define GC_MARK_YOUNG 2
+
 static void add_gc_object(JSRuntime *rt, JSGCObjectHeader *h,
                           JSGCObjectTypeEnum type)
 {
-    h->mark = 0;
     h->gc_obj_type = type;
-    list_add_tail(&h->link, &rt->gc_obj_list);
+    if (rt->gc_generational && type == JS_GC_OBJ_TYPE_JS_OBJECT) {
+        h->mark = GC_MARK_YOUNG;
+        list_add_tail(&h->link, &rt->gc_young_obj_list);
+    } else {
+        h->mark = 0;
+        list_add_tail(&h->link, &rt->gc_obj_list);
+    }
 }
 
 static void remove_gc_object(JSGCObjectHeader *h)
@@ -5700,6 +6515,7 @@ static void gc_decref(JSRuntime *rt)
         assert(p->mark == 0);
         mark_children(rt, p, gc_decref_child);
         p->mark = 1;
+        rt->gc_stats.last_objects_scanned++;
         if (p->ref_count == 0) {
             list_del(&p->link);
             list_add_tail(&p->link, &rt->tmp_obj_list);
@@ -5730,12 +6546,15 @@ static void gc_scan(JSRuntime *rt)
     JSGCObjectHeader *p;
 
     /* keep the objects with a refcount > 0 and their children. */
+    rt->gc_old_count = 0;
     list_for_each(el, &rt->gc_obj_list) {
         p = list_entry(el, JSGCObjectHeader, link);
         assert(p->ref_count > 0);
         p->mark = 0; /* reset the mark for the next GC call */
         mark_children(rt, p, gc_scan_incref_child);
+        rt->gc_old_count++;
     }
+    rt->gc_promoted_count = 0;
     
     /* restore the refcount of the objects to be deleted. */
     list_for_each(el, &rt->tmp_obj_list) {
@@ -5774,6 +6593,7 @@ static void gc_free_cycles(JSRuntime *rt)
             JS_DumpGCObject(rt, p);
 #endif
             free_gc_object(rt, p);
+            rt->gc_stats.last_objects_freed++;
             break;
         default:
             list_del(&p->link);
@@ -5787,14 +6607,185 @@ static void gc_free_cycles(JSRuntime *rt)
         p = list_entry(el, JSGCObjectHeader, link);
         assert(p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT ||
                p->gc_obj_type == JS_GC_OBJ_TYPE_FUNCTION_BYTECODE);
-        js_free_rt(rt, p);
+        if (p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT)
+            js_slab_free(rt, p, sizeof(JSObject));
+        else
+            js_free_rt(rt, p);
     }
 
     init_list_head(&rt->gc_zero_ref_count_list);
 }
 
-void JS_RunGC(JSRuntime *rt)
+/* move the young objects to the old generation */
+static void gc_promote_young(JSRuntime *rt)
 {
+    struct list_head *el, *el1;
+    JSGCObjectHeader *p;
+
+    list_for_each_safe(el, el1, &rt->gc_young_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        p->mark = 0;
+        list_del(&p->link);
+        list_add_tail(&p->link, &rt->gc_obj_list);
+        rt->gc_promoted_count++;
+    }
+}
+
+/* Partial collection: same algorithm as JS_RunGC() restricted to the
+   objects of gc_young_obj_list, i.e. the young objects and, for a GC
+   slice, a part of the old objects. The other objects are not scanned,
+   so the references they hold keep the collected objects alive: only
+   the cycles entirely contained in the collected set are freed. Since
+   the mutator does not run during a collection, no write barrier is
+   needed. */
+static void gc_decref_young_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    if (p->mark != 0)
+        gc_decref_child(rt, p);
+}
+
+static void gc_scan_incref_young_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    if (p->mark != 0) {
+        p->ref_count++;
+        if (p->ref_count == 1) {
+            list_del(&p->link);
+            list_add_tail(&p->link, &rt->gc_young_obj_list);
+        }
+    }
+}
+
+static void gc_scan_incref_young_child2(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    if (p->mark != 0)
+        p->ref_count++;
+}
+
+/* add an old object to the collected set */
+static void gc_slice_add(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    p->mark = GC_MARK_YOUNG;
+    list_del(&p->link);
+    list_add_tail(&p->link, &rt->gc_young_obj_list);
+    rt->gc_slice_left--;
+    /* it is counted again if it is put back in the old generation */
+    rt->gc_promoted_count--;
+}
+
+static void gc_slice_add_child(JSRuntime *rt, JSGCObjectHeader *p)
+{
+    /* the shapes and contexts are not followed: they would add the
+       prototypes and all the intrinsics to every slice */
+    if (p->mark == 0 && rt->gc_slice_left > 0 &&
+        p->gc_obj_type != JS_GC_OBJ_TYPE_SHAPE &&
+        p->gc_obj_type != JS_GC_OBJ_TYPE_JS_CONTEXT) {
+        gc_slice_add(rt, p);
+    }
+}
+
+/* Add about 'old_count' old objects to the collected set. They are
+   taken at the start of gc_obj_list and the survivors are put back at
+   the end, so that successive slices go through the whole old
+   generation. The old objects they reference are added with them so
+   that the cycles are more likely to be contained in the slice. */
+static void gc_select_slice(JSRuntime *rt, int old_count)
+{
+    struct list_head *el;
+    JSGCObjectHeader *p;
+
+    rt->gc_slice_left = old_count;
+    el = rt->gc_young_obj_list.prev;
+    for(;;) {
+        if (el->next == &rt->gc_young_obj_list) {
+            if (rt->gc_slice_left <= 0 || list_empty(&rt->gc_obj_list))
+                break;
+            p = list_entry(rt->gc_obj_list.next, JSGCObjectHeader, link);
+            gc_slice_add(rt, p);
+        }
+        el = el->next;
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_slice_add_child);
+    }
+}
+
+/* number of old objects which can be added to a slice taking about
+   'budget_us' microseconds, estimated from the previous collections */
+static int gc_slice_size(JSRuntime *rt, int budget_us)
+{
+    const JSGCStats *st = &rt->gc_stats;
+    int64_t n, young_count;
+    struct list_head *el;
+
+    if (st->pause_time > 0)
+        n = budget_us * st->objects_scanned / st->pause_time;
+    else
+        n = budget_us * 20;
+    young_count = 0;
+    list_for_each(el, &rt->gc_young_obj_list) {
+        young_count++;
+    }
+    n -= young_count;
+    /* always make some progress in the old generation */
+    if (n < GC_SLICE_OLD_MIN)
+        n = GC_SLICE_OLD_MIN;
+    else if (n > INT32_MAX)
+        n = INT32_MAX;
+    return n;
+}
+
+static void gc_run_partial(JSRuntime *rt, int old_count)
+{
+    struct list_head *el, *el1;
+    JSGCObjectHeader *p;
+    int promoted_count;
+
+    promoted_count = rt->gc_promoted_count;
+    if (old_count > 0) {
+        gc_select_slice(rt, old_count);
+        rt->gc_slice_debt -= old_count - rt->gc_slice_left;
+    }
+
+    init_list_head(&rt->tmp_obj_list);
+    list_for_each_safe(el, el1, &rt->gc_young_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        assert(p->mark == GC_MARK_YOUNG);
+        mark_children(rt, p, gc_decref_young_child);
+        p->mark = 1;
+        rt->gc_stats.last_objects_scanned++;
+        if (p->ref_count == 0) {
+            list_del(&p->link);
+            list_add_tail(&p->link, &rt->tmp_obj_list);
+        }
+    }
+
+    list_for_each(el, &rt->gc_young_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_scan_incref_young_child);
+    }
+    list_for_each(el, &rt->tmp_obj_list) {
+        p = list_entry(el, JSGCObjectHeader, link);
+        mark_children(rt, p, gc_scan_incref_young_child2);
+    }
+
+    /* the survivors are promoted before freeing the cycles so that
+       only the objects to be deleted have mark = 1 */
+    gc_promote_young(rt);
+    rt->gc_slice_debt += (int64_t)GC_SLICE_OLD_RATIO *
+        (rt->gc_promoted_count - promoted_count);
+    if (rt->gc_slice_debt < 0)
+        rt->gc_slice_debt = 0;
+    /* the slice may have freed more old objects than were promoted
+       since the last full GC */
+    if (rt->gc_promoted_count < 0)
+        rt->gc_promoted_count = 0;
+
+    gc_free_cycles(rt);
+}
+
+static void gc_run_full(JSRuntime *rt)
+{
+    gc_promote_young(rt);
+
     /* decrement the reference of the children of each object. mark =
        1 after this pass. */
     gc_decref(rt);
@@ -5804,6 +6795,50 @@ void JS_RunGC(JSRuntime *rt)
 
     /* free the GC objects in a cycle */
     gc_free_cycles(rt);
+    rt->gc_slice_debt = 0;
+
+    js_slab_trim(rt);
+}
+
+/* full collection if 'old_count' < 0, otherwise partial collection of
+   the young objects and of 'old_count' old objects */
+static void gc_collect(JSRuntime *rt, int old_count)
+{
+    JSGCStats *st = &rt->gc_stats;
+    int64_t start_time;
+    size_t size;
+
+    start_time = js_gc_get_time_us();
+    size = js_heap_size(rt);
+    st->last_objects_scanned = 0;
+    st->last_objects_freed = 0;
+    if (old_count >= 0)
+        gc_run_partial(rt, old_count);
+    else
+        gc_run_full(rt);
+    st->last_pause_time = js_gc_get_time_us() - start_time;
+    st->last_bytes_freed = 0;
+    if (js_heap_size(rt) < size)
+        st->last_bytes_freed = size - js_heap_size(rt);
+    st->gc_count++;
+    if (old_count >= 0)
+        st->minor_gc_count++;
+    st->pause_time += st->last_pause_time;
+    st->objects_scanned += st->last_objects_scanned;
+    st->objects_freed += st->last_objects_freed;
+    st->bytes_freed += st->last_bytes_freed;
+}
+
+void JS_RunGC(JSRuntime *rt)
+{
+    gc_collect(rt, -1);
+}
+
+/* Run a partial collection of about 'budget_us' microseconds. It can be
+   called when the application is idle, e.g. between two jobs. */
+void JS_RunGCSlice(JSRuntime *rt, int budget_us)
+{
+    gc_collect(rt, gc_slice_size(rt, max_int(budget_us, 0)));
 }
 
 /* Return false if not an object or if the object has already been
@@ -5904,11 +6939,19 @@ void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s)
     int i;
     JSMemoryUsage_helper mem = { 0 }, *hp = &mem;
 
+    /* all the GC objects are walked in gc_obj_list */
+    gc_promote_young(rt);
+
     memset(s, 0, sizeof(*s));
     s->malloc_count = rt->malloc_state.malloc_count;
     s->malloc_size = rt->malloc_state.malloc_size;
     s->malloc_limit = rt->malloc_state.malloc_limit;
 
+    for(i = 0; i < JS_SLAB_CLASS_COUNT; i++)
+        s->slab_page_count += rt->slab_classes[i].page_count;
+    s->slab_size = s->slab_page_count * JS_SLAB_PAGE_SIZE;
+    s->slab_free_size = rt->slab_free_size;
+
     s->memory_used_count = 2; /* rt + rt->class_array */
     s->memory_used_size = sizeof(JSRuntime) + sizeof(JSValue) * rt->class_count;
 
@@ -6229,6 +7272,7 @@ void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt)
             int obj_classes[JS_CLASS_INIT_COUNT + 1] = { 0 };
             int class_id;
             struct list_head *el;
+            gc_promote_young(rt);
             list_for_each(el, &rt->gc_obj_list) {
                 JSGCObjectHeader *gp = list_entry(el, JSGCObjectHeader, link);
                 JSObject *p;
@@ -6264,6 +7308,11 @@ void JS_DumpMemoryUsage(FILE *fp, const JSMemoryUsage *s, JSRuntime *rt)
                 MALLOC_OVERHEAD, ((double)(s->malloc_size - s->memory_used_size) /
                                   s->memory_used_count));
     }
+    if (s->slab_page_count) {
+        fprintf(fp, "%-20s %8"PRId64" %8"PRId64"  (%"PRId64" free)\n",
+                "slab pages", s->slab_page_count, s->slab_size,
+                s->slab_free_size);
+    }
     if (s->atom_count) {
         fprintf(fp, "%-20s %8"PRId64" %8"PRId64"  (%0.1f per atom)\n",
                 "atoms", s->atom_count, s->atom_size,
@@ -7045,6 +8094,7 @@ static JSAutoInitFunc *js_autoinit_func_table[] = {
     js_instantiate_prototype, /* JS_AUTOINIT_ID_PROTOTYPE */
     js_module_ns_autoinit, /* JS_AUTOINIT_ID_MODULE_NS */
     JS_InstantiateFunctionListItem2, /* JS_AUTOINIT_ID_PROP */
+    js_lazy_intrinsic_autoinit, /* JS_AUTOINIT_ID_INTRINSIC */
 };
 
 /* warning: 'prs' is reallocated after it */
@@ -7197,6 +8247,9 @@ JSValue JS_GetPropertyInternal(JSContext *ctx, JSValueConst obj,
                         if (ret) {
                             if (desc.flags & JS_PROP_GETSET) {
                                 JS_FreeValue(ctx, desc.setter);
+                                /* an accessor may have no getter */
+                                if (JS_IsUndefined(desc.getter))
+                                    return JS_UNDEFINED;
                                 return JS_CallFree(ctx, desc.getter, this_obj, 0, NULL);
                             } else {
                                 return desc.value;
@@ -11633,26 +12686,29 @@ static JSValue JS_ToStringCheckObject(JSContext *ctx, JSValueConst val)
     return JS_ToString(ctx, val);
 }
 
-static JSValue JS_ToQuotedString(JSContext *ctx, JSValueConst val1)
+/* append 'p' as a JSON quoted string */
+static int string_buffer_put_quoted(StringBuffer *b, JSString *p)
 {
-    JSValue val;
-    JSString *p;
-    int i;
+    int i, n;
     uint32_t c;
-    StringBuffer b_s, *b = &b_s;
     char buf[16];
 
-    val = JS_ToStringCheckObject(ctx, val1);
-    if (JS_IsException(val))
-        return val;
-    p = JS_VALUE_GET_STRING(val);
-
-    if (string_buffer_init(ctx, b, p->len + 2))
-        goto fail;
-
     if (string_buffer_putc8(b, '\"'))
-        goto fail;
+        return -1;
     for(i = 0; i < p->len; ) {
+        /* copy the characters which need no escaping in one go */
+        if (p->is_wide_char) {
+            n = str16_find_json_special(p->u.str16 + i, p->len - i);
+            if (n > 0 && string_buffer_write16(b, p->u.str16 + i, n))
+                return -1;
+        } else {
+            n = str8_find_json_special(p->u.str8 + i, p->len - i);
+            if (n > 0 && string_buffer_write8(b, p->u.str8 + i, n))
+                return -1;
+        }
+        i += n;
+        if (i >= p->len)
+            break;
         c = string_getc(p, &i);
         switch(c) {
         case '\t':
@@ -11674,23 +12730,39 @@ static JSValue JS_ToQuotedString(JSContext *ctx, JSValueConst val1)
         case '\\':
         quote:
             if (string_buffer_putc8(b, '\\'))
-                goto fail;
+                return -1;
             if (string_buffer_putc8(b, c))
-                goto fail;
+                return -1;
             break;
         default:
             if (c < 32 || (c >= 0xd800 && c < 0xe000)) {
                 snprintf(buf, sizeof(buf), "\\u%04x", c);
                 if (string_buffer_puts8(b, buf))
-                    goto fail;
+                    return -1;
             } else {
                 if (string_buffer_putc(b, c))
-                    goto fail;
+                    return -1;
             }
             break;
         }
     }
-    if (string_buffer_putc8(b, '\"'))
+    return string_buffer_putc8(b, '\"');
+}
+
+static JSValue JS_ToQuotedString(JSContext *ctx, JSValueConst val1)
+{
+    JSValue val;
+    JSString *p;
+    StringBuffer b_s, *b = &b_s;
+
+    val = JS_ToStringCheckObject(ctx, val1);
+    if (JS_IsException(val))
+        return val;
+    p = JS_VALUE_GET_STRING(val);
+
+    if (string_buffer_init(ctx, b, p->len + 2))
+        goto fail;
+    if (string_buffer_put_quoted(b, p))
         goto fail;
     JS_FreeValue(ctx, val);
     return string_buffer_end(b);
@@ -14728,6 +15800,11 @@ static BOOL js_same_value(JSContext *ctx, JSValueConst op1, JSValueConst op2)
                          JS_EQ_SAME_VALUE);
 }
 
+JS_BOOL JS_IsSameValue(JSContext *ctx, JSValueConst op1, JSValueConst op2)
+{
+    return js_same_value(ctx, op1, op2);
+}
+
 static BOOL js_same_value_zero(JSContext *ctx, JSValueConst op1, JSValueConst op2)
 {
     return js_strict_eq2(ctx,
@@ -14940,6 +16017,47 @@ static int js_arguments_define_own_property(JSContext *ctx,
                              flags | JS_PROP_NO_EXOTIC);
 }
 
+/* Create an object with the properties of the template object 'tmpl'
+   (see OP_object_template). The 'n' values are taken over and
+   replaced by undefined. */
+static JSValue js_create_from_template(JSContext *ctx, JSValueConst tmpl,
+                                       JSValue *vals, int n)
+{
+    JSShape *sh = JS_VALUE_GET_OBJ(tmpl)->shape;
+    JSShapeProperty *prs;
+    JSObject *p;
+    JSValue obj;
+    int i, ret;
+
+    if (likely(sh->proto ==
+               JS_VALUE_GET_OBJ(ctx->class_proto[JS_CLASS_OBJECT]))) {
+        obj = JS_NewObjectFromShape(ctx, js_dup_shape(sh), JS_CLASS_OBJECT);
+        if (JS_IsException(obj))
+            return obj;
+        p = JS_VALUE_GET_OBJ(obj);
+        for(i = 0; i < n; i++) {
+            p->prop[i].u.value = vals[i];
+            vals[i] = JS_UNDEFINED;
+        }
+    } else {
+        /* the template comes from another realm */
+        obj = JS_NewObject(ctx);
+        if (JS_IsException(obj))
+            return obj;
+        prs = get_shape_prop(sh);
+        for(i = 0; i < n; i++) {
+            ret = JS_DefinePropertyValue(ctx, obj, prs[i].atom, vals[i],
+                                         JS_PROP_C_W_E | JS_PROP_THROW);
+            vals[i] = JS_UNDEFINED;
+            if (ret < 0) {
+                JS_FreeValue(ctx, obj);
+                return JS_EXCEPTION;
+            }
+        }
+    }
+    return obj;
+}
+
 static const JSClassExoticMethods js_arguments_exotic_methods = {
     .define_own_property = js_arguments_define_own_property,
 };
@@ -16687,6 +17805,20 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                 *sp++ = ret_val;
             }
             BREAK;
+        CASE(OP_object_template):
+            {
+                int n;
+
+                n = get_u16(pc);
+                pc += 2;
+                ret_val = js_create_from_template(ctx, sp[-1], sp - 1 - n, n);
+                if (unlikely(JS_IsException(ret_val)))
+                    goto exception;
+                JS_FreeValue(ctx, sp[-1]);
+                sp -= n + 1;
+                *sp++ = ret_val;
+            }
+            BREAK;
         CASE(OP_array_from):
             {
                 int i, ret;
@@ -17959,10 +19091,8 @@ static JSValue JS_CallInternal(JSContext *caller_ctx, JSValueConst func_obj,
                     op1 = JS_ToPrimitiveFree(ctx, op1, HINT_NONE);
                     if (JS_IsException(op1))
                         goto exception;
-                    op1 = JS_ConcatString(ctx, JS_DupValue(ctx, *pv), op1);
-                    if (JS_IsException(op1))
+                    if (js_concat_string_var(ctx, pv, op1))
                         goto exception;
-                    set_value(ctx, pv, op1);
                 } else {
                     JSValue ops[2];
                 add_loc_slow:
@@ -18782,7 +19912,7 @@ static JSValue js_create_from_ctor(JSContext *ctx, JSValueConst ctor,
     JSContext *realm;
     
     if (JS_IsUndefined(ctor)) {
-        proto = JS_DupValue(ctx, ctx->class_proto[class_id]);
+        proto = JS_DupValue(ctx, js_get_class_proto(ctx, class_id));
     } else {
         proto = JS_GetProperty(ctx, ctor, JS_ATOM_prototype);
         if (JS_IsException(proto))
@@ -18792,7 +19922,7 @@ static JSValue js_create_from_ctor(JSContext *ctx, JSValueConst ctor,
             realm = JS_GetFunctionRealm(ctx, ctor);
             if (!realm)
                 return JS_EXCEPTION;
-            proto = JS_DupValue(ctx, realm->class_proto[class_id]);
+            proto = JS_DupValue(ctx, js_get_class_proto(realm, class_id));
         }
     }
     obj = JS_NewObjectProtoClass(ctx, proto, class_id);
@@ -22640,17 +23770,90 @@ static void set_object_name_computed(JSParseState *s)
     }
 }
 
+/* Object literals whose properties are all 'name: value' or shorthand
+   definitions are compiled as the values followed by
+   OP_object_template, which creates the object in one step with the
+   final shape. The template is an object with the same property names
+   stored in the constant pool, so its shape is computed once per
+   literal. */
+#define OBJECT_TEMPLATE_MAX_FIELDS 32
+
+typedef struct {
+    int count; /* -1 if the literal cannot use a template */
+    int object_pos;
+    int field_pos[OBJECT_TEMPLATE_MAX_FIELDS]; /* OP_define_field positions */
+} ObjectTemplateState;
+
+static void object_template_add_field(JSParseState *s,
+                                      ObjectTemplateState *ts)
+{
+    if (ts->count >= 0) {
+        if (ts->count < OBJECT_TEMPLATE_MAX_FIELDS)
+            ts->field_pos[ts->count++] = s->cur_func->last_opcode_pos;
+        else
+            ts->count = -1;
+    }
+}
+
+/* replace the OP_object and OP_define_field opcodes of the object
+   literal by an OP_object_template at the end. Nothing is changed if a
+   property name is duplicated. */
+static __exception int emit_object_template(JSParseState *s,
+                                            ObjectTemplateState *ts)
+{
+    JSFunctionDef *fd = s->cur_func;
+    JSValue tmpl;
+    uint8_t *bc_buf;
+    JSAtom atom;
+    int i, idx;
+
+    tmpl = JS_NewObject(s->ctx);
+    if (JS_IsException(tmpl))
+        return -1;
+    bc_buf = fd->byte_code.buf;
+    for(i = 0; i < ts->count; i++) {
+        atom = get_u32(bc_buf + ts->field_pos[i] + 1);
+        if (JS_DefinePropertyValue(s->ctx, tmpl, atom, JS_UNDEFINED,
+                                   JS_PROP_C_W_E) < 0)
+            goto fail;
+    }
+    if (JS_VALUE_GET_OBJ(tmpl)->shape->prop_count != ts->count) {
+        JS_FreeValue(s->ctx, tmpl);
+        return 0;
+    }
+    idx = cpool_add(s, tmpl);
+    if (idx < 0)
+        goto fail;
+    bc_buf[ts->object_pos] = OP_nop;
+    for(i = 0; i < ts->count; i++) {
+        atom = get_u32(bc_buf + ts->field_pos[i] + 1);
+        JS_FreeAtom(s->ctx, atom);
+        memset(bc_buf + ts->field_pos[i], OP_nop, 5);
+    }
+    emit_op(s, OP_push_const);
+    emit_u32(s, idx);
+    emit_op(s, OP_object_template);
+    emit_u16(s, ts->count);
+    return 0;
+ fail:
+    JS_FreeValue(s->ctx, tmpl);
+    return -1;
+}
+
 static __exception int js_parse_object_literal(JSParseState *s)
 {
     JSAtom name = JS_ATOM_NULL;
     const uint8_t *start_ptr;
     int start_line, prop_type;
     BOOL has_proto;
+    ObjectTemplateState ts;
 
     if (next_token(s))
         goto fail;
     /* XXX: add an initial length that will be patched back */
     emit_op(s, OP_object);
+    ts.count = 0;
+    ts.object_pos = s->cur_func->last_opcode_pos;
     has_proto = FALSE;
     while (s->token.val != '}') {
         /* specific case for getter/setter */
@@ -22658,6 +23861,7 @@ static __exception int js_parse_object_literal(JSParseState *s)
         start_line = s->token.line_num;
 
         if (s->token.val == TOK_ELLIPSIS) {
+            ts.count = -1;
             if (next_token(s))
                 return -1;
             if (js_parse_assign_expr(s))
@@ -22681,6 +23885,7 @@ static __exception int js_parse_object_literal(JSParseState *s)
             emit_u16(s, s->cur_func->scope_level);
             emit_op(s, OP_define_field);
             emit_atom(s, name);
+            object_template_add_field(s, &ts);
         } else if (s->token.val == '(') {
             BOOL is_getset = (prop_type == PROP_TYPE_GET ||
                               prop_type == PROP_TYPE_SET);
@@ -22688,6 +23893,7 @@ static __exception int js_parse_object_literal(JSParseState *s)
             JSFunctionKindEnum func_kind;
             int op_flags;
 
+            ts.count = -1;
             func_kind = JS_FUNC_NORMAL;
             if (is_getset) {
                 func_type = JS_PARSE_FUNC_GETTER + prop_type - PROP_TYPE_GET;
@@ -22722,6 +23928,7 @@ static __exception int js_parse_object_literal(JSParseState *s)
             if (js_parse_assign_expr(s))
                 goto fail;
             if (name == JS_ATOM_NULL) {
+                ts.count = -1;
                 set_object_name_computed(s);
                 emit_op(s, OP_define_array_el);
                 emit_op(s, OP_drop);
@@ -22730,12 +23937,14 @@ static __exception int js_parse_object_literal(JSParseState *s)
                     js_parse_error(s, "duplicate __proto__ property name");
                     goto fail;
                 }
+                ts.count = -1;
                 emit_op(s, OP_set_proto);
                 has_proto = TRUE;
             } else {
                 set_object_name(s, name);
                 emit_op(s, OP_define_field);
                 emit_atom(s, name);
+                object_template_add_field(s, &ts);
             }
         }
         JS_FreeAtom(s->ctx, name);
@@ -22748,6 +23957,8 @@ static __exception int js_parse_object_literal(JSParseState *s)
     }
     if (js_parse_expect(s, '}'))
         goto fail;
+    if (ts.count > 0 && emit_object_template(s, &ts))
+        goto fail;
     return 0;
  fail:
     JS_FreeAtom(s->ctx, name);
@@ -33878,9 +35089,9 @@ typedef enum BCTagEnum {
 } BCTagEnum;
 
 #ifdef CONFIG_BIGNUM
-#define BC_BASE_VERSION 2
+#define BC_BASE_VERSION 4
 #else
-#define BC_BASE_VERSION 1
+#define BC_BASE_VERSION 3
 #endif
 #define BC_BE_VERSION 0x40
 #ifdef WORDS_BIGENDIAN
@@ -35701,7 +36912,7 @@ static JSValue JS_ReadDate(BCReaderState *s)
         JS_ThrowTypeError(ctx, "Number tag expected for date");
         goto fail;
     }
-    obj = JS_NewObjectProtoClass(ctx, ctx->class_proto[JS_CLASS_DATE],
+    obj = JS_NewObjectProtoClass(ctx, js_get_class_proto(ctx, JS_CLASS_DATE),
                                  JS_CLASS_DATE);
     if (JS_IsException(obj))
         goto fail;
@@ -40436,16 +41647,14 @@ static int string_indexof_char(JSString *p, int c, int from)
     /* assuming 0 <= from <= p->len */
     int i, len = p->len;
     if (p->is_wide_char) {
-        for (i = from; i < len; i++) {
-            if (p->u.str16[i] == c)
-                return i;
-        }
+        i = from + str16_find_char(p->u.str16 + from, len - from, c);
+        if (i < len)
+            return i;
     } else {
         if ((c & ~0xff) == 0) {
-            for (i = from; i < len; i++) {
-                if (p->u.str8[i] == (uint8_t)c)
-                    return i;
-            }
+            i = from + str8_find_char(p->u.str8 + from, len - from, c);
+            if (i < len)
+                return i;
         }
     }
     return -1;
@@ -40524,7 +41733,9 @@ static JSValue js_string_indexOf(JSContext *ctx, JSValueConst this_val,
         inc = 1;
     }
     ret = -1;
-    if (len >= v_len && inc * (stop - start) >= 0) {
+    if (inc > 0) {
+        ret = string_indexof(p, p1, pos);
+    } else if (len >= v_len && inc * (stop - start) >= 0) {
         for (i = start;; i += inc) {
             if (!string_cmp(p, p1, i, 0, v_len)) {
                 ret = i;
@@ -40551,7 +41762,7 @@ static JSValue js_string_includes(JSContext *ctx, JSValueConst this_val,
                                   int argc, JSValueConst *argv, int magic)
 {
     JSValue str, v = JS_UNDEFINED;
-    int i, len, v_len, pos, start, stop, ret;
+    int len, v_len, pos, ret;
     JSString *p;
     JSString *p1;
 
@@ -40579,8 +41790,7 @@ static JSValue js_string_includes(JSContext *ctx, JSValueConst this_val,
     len -= v_len;
     ret = 0;
     if (magic == 0) {
-        start = pos;
-        stop = len;
+        ret = string_indexof(p, p1, pos) >= 0;
     } else {
         if (magic == 1) {
             if (pos > len)
@@ -40588,17 +41798,8 @@ static JSValue js_string_includes(JSContext *ctx, JSValueConst this_val,
         } else {
             pos -= v_len;
         }
-        start = stop = pos;
-    }
-    if (start >= 0 && start <= stop) {
-        for (i = start;; i++) {
-            if (!string_cmp(p, p1, i, 0, v_len)) {
-                ret = 1;
-                break;
-            }
-            if (i == stop)
-                break;
-        }
+        if (pos >= 0 && !string_cmp(p, p1, pos, 0, v_len))
+            ret = 1;
     }
  done:
     JS_FreeValue(ctx, str);
@@ -43655,12 +44856,480 @@ static JSValue json_parse_value(JSParseState *s)
     return JS_EXCEPTION;
 }
 
+/* Fast path for standard JSON. It builds the values directly from the
+   UTF-8 input without going through the tokenizer. Anything it does
+   not handle (syntax errors, unusual escapes, deep nesting) makes it
+   give up so that json_parse_value() can parse the input again and
+   report the errors. */
+
+typedef struct JSONParseState {
+    JSContext *ctx;
+    const uint8_t *buf_ptr;
+    const uint8_t *buf_end;
+    BOOL give_up; /* the input must be parsed by json_parse_value() */
+    /* pending object properties */
+    JSAtom *keys;
+    JSValue *vals;
+    int sp;
+    int size;
+} JSONParseState;
+
+static JSValue json_fast_parse_value(JSONParseState *s);
+
+static JSValue json_fast_give_up(JSONParseState *s)
+{
+    s->give_up = TRUE;
+    return JS_EXCEPTION;
+}
+
+static inline const uint8_t *json_skip_ws(const uint8_t *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        p++;
+    return p;
+}
+
+/* 'p' points after the opening quote. Return the length of the string
+   if it is made of ASCII characters without escapes, -1 otherwise. */
+static int json_plain_string_len(JSONParseState *s, const uint8_t *p)
+{
+    size_t n;
+
+    n = str8_find_json_special(p, s->buf_end - p);
+    if (p + n >= s->buf_end || p[n] != '\"' ||
+        str8_find_non_ascii(p, n) != n || n > JS_STRING_LEN_MAX)
+        return -1;
+    return n;
+}
+
+static JSValue json_fast_parse_string(JSONParseState *s)
+{
+    JSContext *ctx = s->ctx;
+    const uint8_t *p, *q;
+    StringBuffer b_s, *b = &b_s;
+    size_t n;
+    int c, ret;
+
+    p = s->buf_ptr + 1;
+    ret = json_plain_string_len(s, p);
+    if (ret >= 0) {
+        s->buf_ptr = p + ret + 1;
+        return js_new_string8(ctx, p, ret);
+    }
+
+    if (string_buffer_init(ctx, b, 32))
+        return JS_EXCEPTION;
+    for(;;) {
+        /* copy the characters up to the next quote, escape or
+           control character */
+        n = str8_find_json_special(p, s->buf_end - p);
+        q = p + n;
+        while (p < q) {
+            n = str8_find_non_ascii(p, q - p);
+            if (string_buffer_write8(b, p, n))
+                goto fail;
+            p += n;
+            if (p < q) {
+                c = unicode_from_utf8(p, q - p, &p);
+                if (c < 0 || c > 0x10FFFF)
+                    goto give_up;
+                if (string_buffer_putc(b, c))
+                    goto fail;
+            }
+        }
+        if (p >= s->buf_end)
+            goto give_up;
+        c = *p++;
+        if (c == '\"')
+            break;
+        if (c != '\\')
+            goto give_up;
+        c = *p;
+        switch(c) {
+        case '\"':
+        case '\\':
+        case '/':
+            p++;
+            break;
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+        case 'u':
+            c = lre_parse_escape(&p, TRUE);
+            if (c < 0)
+                goto give_up;
+            break;
+        default:
+            goto give_up;
+        }
+        if (string_buffer_putc(b, c))
+            goto fail;
+    }
+    s->buf_ptr = p;
+    return string_buffer_end(b);
+ give_up:
+    s->give_up = TRUE;
+ fail:
+    string_buffer_free(b);
+    return JS_EXCEPTION;
+}
+
+/* Property names are looked up in a small cache before the atom hash
+   table. The key bytes are compared with the cached atom so that
+   recurring names are neither hashed nor allocated. */
+static JSAtom json_fast_parse_key(JSONParseState *s)
+{
+    JSContext *ctx = s->ctx;
+    const uint8_t *p;
+    JSAtomStruct *str;
+    JSAtom atom;
+    JSValue val;
+    uint32_t h;
+    int len;
+
+    p = s->buf_ptr + 1;
+    len = json_plain_string_len(s, p);
+    if (len < 0) {
+        val = json_fast_parse_string(s);
+        if (JS_IsException(val))
+            return JS_ATOM_NULL;
+        return JS_NewAtomStr(ctx, JS_VALUE_GET_STRING(val));
+    }
+    s->buf_ptr = p + len + 1;
+    /* integer keys are not cached */
+    if (len == 0 || is_digit(p[0]))
+        return JS_NewAtomLen(ctx, (const char *)p, len);
+    h = shape_hash(shape_hash(shape_hash(len, p[0]), p[len >> 1]), p[len - 1]);
+    h = get_shape_hash(h, JSON_KEY_CACHE_BITS);
+    atom = ctx->json_key_cache[h];
+    if (atom != JS_ATOM_NULL) {
+        str = ctx->rt->atom_array[atom];
+        if (str->len == len && !str->is_wide_char &&
+            !memcmp(str->u.str8, p, len))
+            return JS_DupAtom(ctx, atom);
+    }
+    atom = JS_NewAtomLen(ctx, (const char *)p, len);
+    if (atom != JS_ATOM_NULL) {
+        JS_FreeAtom(ctx, ctx->json_key_cache[h]);
+        ctx->json_key_cache[h] = JS_DupAtom(ctx, atom);
+    }
+    return atom;
+}
+
+static JSValue json_fast_parse_number(JSONParseState *s)
+{
+    JSContext *ctx = s->ctx;
+    const uint8_t *p, *q;
+    JSValue val;
+    BOOL is_neg;
+    int v;
+
+    p = s->buf_ptr;
+    is_neg = (*p == '-');
+    q = p + is_neg;
+    if (!is_digit(*q) || (*q == '0' && is_digit(q[1])))
+        return json_fast_give_up(s);
+    /* small integers are converted directly */
+    v = 0;
+    while (is_digit(*q) && q - p < 9)
+        v = v * 10 + (*q++ - '0');
+    if (!is_digit(*q) && *q != '.' && *q != 'e' && *q != 'E' &&
+        !(is_neg && v == 0)) {
+        s->buf_ptr = q;
+        return JS_NewInt32(ctx, is_neg ? -v : v);
+    }
+    val = js_atof(ctx, (const char *)p, (const char **)&p, 10, 0);
+    s->buf_ptr = p;
+    return val;
+}
+
+static int json_fast_push(JSONParseState *s, JSAtom key, JSValue val)
+{
+    JSContext *ctx = s->ctx;
+    JSAtom *keys;
+    JSValue *vals;
+    int new_size;
+
+    if (unlikely(s->sp >= s->size)) {
+        new_size = max_int(16, s->size * 3 / 2);
+        keys = js_realloc(ctx, s->keys, sizeof(s->keys[0]) * new_size);
+        if (!keys)
+            goto fail;
+        s->keys = keys;
+        vals = js_realloc(ctx, s->vals, sizeof(s->vals[0]) * new_size);
+        if (!vals)
+            goto fail;
+        s->vals = vals;
+        s->size = new_size;
+    }
+    s->keys[s->sp] = key;
+    s->vals[s->sp] = val;
+    s->sp++;
+    return 0;
+ fail:
+    JS_FreeAtom(ctx, key);
+    JS_FreeValue(ctx, val);
+    return -1;
+}
+
+/* Objects with the same property names in the same order share their
+   shape, so the last shape built for each key list is cached and new
+   objects are allocated with all their properties at once. */
+static JSValue json_fast_new_object(JSONParseState *s, int base)
+{
+    JSContext *ctx = s->ctx;
+    JSAtom *keys = s->keys + base;
+    JSValue *vals = s->vals + base;
+    int i, n = s->sp - base;
+    JSShape *sh, **psh;
+    JSShapeProperty *prs;
+    JSProperty *pr;
+    JSObject *p;
+    JSValue obj;
+    uint32_t h;
+
+    h = 0;
+    for(i = 0; i < n; i++)
+        h = shape_hash(h, keys[i]);
+    psh = &ctx->json_shape_cache[get_shape_hash(h, JSON_SHAPE_CACHE_BITS)];
+    sh = *psh;
+    if (sh && sh->prop_count == n) {
+        prs = get_shape_prop(sh);
+        for(i = 0; i < n; i++) {
+            if (prs[i].atom != keys[i] ||
+                prs[i].flags != JS_PROP_C_W_E)
+                break;
+        }
+        if (i == n) {
+            obj = JS_NewObjectFromShape(ctx, js_dup_shape(sh),
+                                        JS_CLASS_OBJECT);
+            if (JS_IsException(obj)) {
+                i = 0;
+                goto fail;
+            }
+            p = JS_VALUE_GET_OBJ(obj);
+            for(i = 0; i < n; i++)
+                p->prop[i].u.value = vals[i];
+            goto done;
+        }
+    }
+
+    i = 0;
+    obj = JS_NewObject(ctx);
+    if (JS_IsException(obj))
+        goto fail;
+    p = JS_VALUE_GET_OBJ(obj);
+    for(i = 0; i < n; i++) {
+        /* the last duplicate property name wins */
+        prs = find_own_property(&pr, p, keys[i]);
+        if (prs) {
+            set_value(ctx, &pr->u.value, vals[i]);
+        } else {
+            pr = add_property(ctx, p, keys[i], JS_PROP_C_W_E);
+            if (!pr) {
+                JS_FreeValue(ctx, obj);
+                goto fail;
+            }
+            pr->u.value = vals[i];
+        }
+    }
+    sh = p->shape;
+    if (n > 0 && sh->prop_count == n && sh->is_hashed) {
+        js_free_shape_null(ctx->rt, *psh);
+        *psh = js_dup_shape(sh);
+    }
+ done:
+    for(i = 0; i < n; i++)
+        JS_FreeAtom(ctx, keys[i]);
+    s->sp = base;
+    return obj;
+ fail:
+    for(; i < n; i++)
+        JS_FreeValue(ctx, vals[i]);
+    for(i = 0; i < n; i++)
+        JS_FreeAtom(ctx, keys[i]);
+    s->sp = base;
+    return JS_EXCEPTION;
+}
+
+static JSValue json_fast_parse_object(JSONParseState *s)
+{
+    JSContext *ctx = s->ctx;
+    const uint8_t *p;
+    JSAtom key;
+    JSValue val;
+    int i, base;
+
+    base = s->sp;
+    p = json_skip_ws(s->buf_ptr + 1);
+    if (*p != '}') {
+        for(;;) {
+            if (*p != '\"') {
+                s->give_up = TRUE;
+                goto fail;
+            }
+            s->buf_ptr = p;
+            key = json_fast_parse_key(s);
+            if (key == JS_ATOM_NULL)
+                goto fail;
+            p = json_skip_ws(s->buf_ptr);
+            if (*p != ':') {
+                JS_FreeAtom(ctx, key);
+                s->give_up = TRUE;
+                goto fail;
+            }
+            s->buf_ptr = json_skip_ws(p + 1);
+            val = json_fast_parse_value(s);
+            if (JS_IsException(val)) {
+                JS_FreeAtom(ctx, key);
+                goto fail;
+            }
+            if (json_fast_push(s, key, val))
+                goto fail;
+            p = json_skip_ws(s->buf_ptr);
+            if (*p != ',')
+                break;
+            p = json_skip_ws(p + 1);
+        }
+        if (*p != '}') {
+            s->give_up = TRUE;
+            goto fail;
+        }
+    }
+    s->buf_ptr = p + 1;
+    return json_fast_new_object(s, base);
+ fail:
+    for(i = base; i < s->sp; i++) {
+        JS_FreeAtom(ctx, s->keys[i]);
+        JS_FreeValue(ctx, s->vals[i]);
+    }
+    s->sp = base;
+    return JS_EXCEPTION;
+}
+
+static JSValue json_fast_parse_array(JSONParseState *s)
+{
+    JSContext *ctx = s->ctx;
+    const uint8_t *p;
+    JSValue obj, el;
+
+    obj = JS_NewArray(ctx);
+    if (JS_IsException(obj))
+        return obj;
+    p = json_skip_ws(s->buf_ptr + 1);
+    if (*p != ']') {
+        for(;;) {
+            s->buf_ptr = p;
+            el = json_fast_parse_value(s);
+            if (JS_IsException(el))
+                goto fail;
+            if (add_fast_array_element(ctx, JS_VALUE_GET_OBJ(obj), el,
+                                       JS_PROP_C_W_E) < 0)
+                goto fail;
+            p = json_skip_ws(s->buf_ptr);
+            if (*p != ',')
+                break;
+            p = json_skip_ws(p + 1);
+        }
+        if (*p != ']') {
+            s->give_up = TRUE;
+            goto fail;
+        }
+    }
+    s->buf_ptr = p + 1;
+    return obj;
+ fail:
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+}
+
+static BOOL json_fast_match(JSONParseState *s, const char *str, int len)
+{
+    const uint8_t *p = s->buf_ptr;
+    if (s->buf_end - p < len || memcmp(p, str, len) != 0 ||
+        lre_js_is_ident_next(p[len]))
+        return FALSE;
+    s->buf_ptr = p + len;
+    return TRUE;
+}
+
+/* 's->buf_ptr' must point to the first character of the value */
+static JSValue json_fast_parse_value(JSONParseState *s)
+{
+    switch(*s->buf_ptr) {
+    case '{':
+        if (js_check_stack_overflow(s->ctx->rt, 0))
+            return json_fast_give_up(s);
+        return json_fast_parse_object(s);
+    case '[':
+        if (js_check_stack_overflow(s->ctx->rt, 0))
+            return json_fast_give_up(s);
+        return json_fast_parse_array(s);
+    case '\"':
+        return json_fast_parse_string(s);
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return json_fast_parse_number(s);
+    case 't':
+        if (json_fast_match(s, "true", 4))
+            return JS_TRUE;
+        break;
+    case 'f':
+        if (json_fast_match(s, "false", 5))
+            return JS_FALSE;
+        break;
+    case 'n':
+        if (json_fast_match(s, "null", 4))
+            return JS_NULL;
+        break;
+    }
+    return json_fast_give_up(s);
+}
+
+/* return 0 if the input was parsed, -1 if an exception is pending and
+   1 if it must be parsed by json_parse_value() */
+static int json_fast_parse(JSContext *ctx, JSValue *pval,
+                           const char *buf, size_t buf_len)
+{
+    JSONParseState s1, *s = &s1;
+    JSValue val;
+
+    memset(s, 0, sizeof(*s));
+    s->ctx = ctx;
+    s->buf_ptr = json_skip_ws((const uint8_t *)buf);
+    s->buf_end = (const uint8_t *)buf + buf_len;
+    val = json_fast_parse_value(s);
+    js_free(ctx, s->keys);
+    js_free(ctx, s->vals);
+    if (JS_IsException(val))
+        return s->give_up ? 1 : -1;
+    if (json_skip_ws(s->buf_ptr) != s->buf_end) {
+        JS_FreeValue(ctx, val);
+        return 1;
+    }
+    *pval = val;
+    return 0;
+}
+
 JSValue JS_ParseJSON2(JSContext *ctx, const char *buf, size_t buf_len,
                       const char *filename, int flags)
 {
     JSParseState s1, *s = &s1;
     JSValue val = JS_UNDEFINED;
 
+    if (!(flags & JS_PARSE_JSON_EXT)) {
+        switch(json_fast_parse(ctx, &val, buf, buf_len)) {
+        case 0:
+            return val;
+        case -1:
+            return JS_EXCEPTION;
+        default:
+            break;
+        }
+    }
     js_parse_init(ctx, s, buf, buf_len, filename);
     s->ext_json = ((flags & JS_PARSE_JSON_EXT) != 0);
     if (json_next_token(s))
@@ -44061,8 +45730,435 @@ exception:
     return -1;
 }
 
-JSValue JS_JSONStringify(JSContext *ctx, JSValueConst obj,
-                         JSValueConst replacer, JSValueConst space0)
+/* Fast path of JSON.stringify() without replacer nor indentation. It
+   handles plain data: ordinary objects with data properties and fast
+   arrays, with the default prototypes and no toJSON() method. The
+   result is written to a string buffer or as UTF-8. On anything else,
+   including cycles, it gives up and the generic algorithm is used.
+   Since no JS code is run, giving up has no visible effect. */
+
+#define JSON_FAST_MAX_DEPTH 256
+
+typedef struct JSONFastState {
+    JSContext *ctx;
+    StringBuffer *sb; /* JS string output */
+    DynBuf *b; /* UTF-8 output if 'sb' is NULL */
+    int depth;
+} JSONFastState;
+
+static void json_free_shape_keys(JSRuntime *rt, JSONShapeKeys *keys)
+{
+    if (keys) {
+        js_free_shape(rt, keys->shape);
+        js_free_rt(rt, keys->offsets);
+        js_free_rt(rt, keys);
+    }
+}
+
+static inline void json_putc(DynBuf *b, uint8_t c)
+{
+    if (likely(b->size < b->allocated_size))
+        b->buf[b->size++] = c;
+    else
+        dbuf_putc(b, c);
+}
+
+/* same escapes as JS_ToQuotedString() */
+static void json_put_escape(DynBuf *b, uint32_t c)
+{
+    static const char hex[] = "0123456789abcdef";
+    uint8_t buf[6];
+
+    buf[0] = '\\';
+    switch(c) {
+    case '\t': buf[1] = 't'; break;
+    case '\r': buf[1] = 'r'; break;
+    case '\n': buf[1] = 'n'; break;
+    case '\b': buf[1] = 'b'; break;
+    case '\f': buf[1] = 'f'; break;
+    case '\"':
+    case '\\':
+        buf[1] = c;
+        break;
+    default:
+        buf[1] = 'u';
+        buf[2] = hex[(c >> 12) & 15];
+        buf[3] = hex[(c >> 8) & 15];
+        buf[4] = hex[(c >> 4) & 15];
+        buf[5] = hex[c & 15];
+        dbuf_put(b, buf, 6);
+        return;
+    }
+    dbuf_put(b, buf, 2);
+}
+
+static void json_put_quoted(DynBuf *b, JSString *p)
+{
+    uint8_t buf[UTF8_CHAR_LEN_MAX];
+    uint32_t c, i, end, len = p->len;
+    size_t n;
+
+    /* most strings need no escaping and fit in len + 2 bytes */
+    dbuf_realloc(b, b->size + len + 2);
+    json_putc(b, '\"');
+    i = 0;
+    if (!p->is_wide_char) {
+        const uint8_t *str = p->u.str8;
+        while (i < len) {
+            end = i + str8_find_json_special(str + i, len - i);
+            while (i < end) {
+                n = str8_find_non_ascii(str + i, end - i);
+                dbuf_put(b, str + i, n);
+                i += n;
+                if (i < end) {
+                    c = str[i++];
+                    json_putc(b, (c >> 6) | 0xc0);
+                    json_putc(b, (c & 0x3f) | 0x80);
+                }
+            }
+            if (i < len)
+                json_put_escape(b, str[i++]);
+        }
+    } else {
+        const uint16_t *str = p->u.str16;
+        while (i < len) {
+            end = i + str16_find_json_special(str + i, len - i);
+            for(; i < end; i++) {
+                c = str[i];
+                if (c < 0x80)
+                    json_putc(b, c);
+                else
+                    dbuf_put(b, buf, unicode_to_utf8(buf, c));
+            }
+            if (i < len) {
+                c = str[i++];
+                if (c >= 0xd800 && c < 0xdc00 && i < len &&
+                    str[i] >= 0xdc00 && str[i] < 0xe000) {
+                    /* surrogate pair */
+                    c = (((c & 0x3ff) << 10) | (str[i++] & 0x3ff)) + 0x10000;
+                    dbuf_put(b, buf, unicode_to_utf8(buf, c));
+                } else {
+                    json_put_escape(b, c);
+                }
+            }
+        }
+    }
+    json_putc(b, '\"');
+}
+
+/* the output functions only take ASCII characters, except for
+   json_fast_put_quoted() */
+static void json_fast_put(JSONFastState *s, const char *str, int len)
+{
+    if (s->sb)
+        string_buffer_write8(s->sb, (const uint8_t *)str, len);
+    else
+        dbuf_put(s->b, (const uint8_t *)str, len);
+}
+
+static void json_fast_puts(JSONFastState *s, const char *str)
+{
+    json_fast_put(s, str, strlen(str));
+}
+
+static inline void json_fast_putc(JSONFastState *s, uint8_t c)
+{
+    if (s->sb)
+        string_buffer_putc8(s->sb, c);
+    else
+        json_putc(s->b, c);
+}
+
+static void json_fast_put_quoted(JSONFastState *s, JSString *p)
+{
+    if (s->sb)
+        string_buffer_put_quoted(s->sb, p);
+    else
+        json_put_quoted(s->b, p);
+}
+
+static void json_fast_put_int(JSONFastState *s, int32_t v)
+{
+    char buf[12], *q = buf + sizeof(buf);
+    uint32_t u = v < 0 ? -(uint32_t)v : v;
+
+    do {
+        *--q = '0' + u % 10;
+        u /= 10;
+    } while (u != 0);
+    if (v < 0)
+        *--q = '-';
+    json_fast_put(s, q, buf + sizeof(buf) - q);
+}
+
+/* return TRUE if 'p' and its prototypes cannot provide toJSON() */
+static BOOL json_proto_is_plain(JSObject *p)
+{
+    while (p) {
+        if (p->class_id == JS_CLASS_PROXY ||
+            find_own_property1(p, JS_ATOM_toJSON))
+            return FALSE;
+        p = p->shape->proto;
+    }
+    return TRUE;
+}
+
+/* Set '*pkeys' to the quoted property names of the objects of shape
+   'sh', or to NULL if they must be handled by the generic algorithm.
+   Return -1 in case of memory error. */
+static int json_get_shape_keys(JSContext *ctx, JSShape *sh,
+                               JSONShapeKeys **pkeys)
+{
+    JSRuntime *rt = ctx->rt;
+    JSONShapeKeys *keys, **pcache;
+    JSShapeProperty *prs;
+    JSAtomStruct *str;
+    JSObject *proto;
+    DynBuf names;
+    uint32_t h, *offsets;
+    BOOL is_plain;
+    int i;
+
+    /* Only hashed shapes are cached: the reference held by the cache
+       makes them shared, hence immutable. */
+    *pkeys = NULL;
+    if (!sh->is_hashed)
+        return 0;
+    h = get_shape_hash(shape_hash(0, (uintptr_t)sh >> 3),
+                       JSON_KEYS_CACHE_BITS);
+    pcache = &ctx->json_keys_cache[h];
+    keys = *pcache;
+    if (keys && keys->shape == sh)
+        goto done;
+
+    proto = JS_VALUE_GET_OBJ(ctx->class_proto[JS_CLASS_OBJECT]);
+    is_plain = (!sh->proto || sh->proto == proto);
+    for(i = 0, prs = get_shape_prop(sh); is_plain && i < sh->prop_count;
+        i++, prs++) {
+        /* toJSON() is used even if it is not enumerable */
+        if (prs->atom == JS_ATOM_toJSON) {
+            is_plain = FALSE;
+            break;
+        }
+        if (prs->atom == JS_ATOM_NULL || !(prs->flags & JS_PROP_ENUMERABLE))
+            continue;
+        /* integer keys come first in the enumeration order */
+        if ((prs->flags & JS_PROP_TMASK) != JS_PROP_NORMAL ||
+            __JS_AtomIsTaggedInt(prs->atom))
+            is_plain = FALSE;
+    }
+
+    offsets = NULL;
+    js_dbuf_init(ctx, &names);
+    if (is_plain) {
+        offsets = js_malloc(ctx, sizeof(offsets[0]) * (sh->prop_count + 1));
+        if (!offsets)
+            return -1;
+        for(i = 0, prs = get_shape_prop(sh); i < sh->prop_count; i++, prs++) {
+            offsets[i] = names.size;
+            if (prs->atom == JS_ATOM_NULL ||
+                !(prs->flags & JS_PROP_ENUMERABLE))
+                continue;
+            str = rt->atom_array[prs->atom];
+            /* symbols are ignored */
+            if (str->atom_type != JS_ATOM_TYPE_STRING)
+                continue;
+            json_put_quoted(&names, str);
+            json_putc(&names, ':');
+        }
+        offsets[i] = names.size;
+        if (dbuf_error(&names))
+            goto fail;
+    }
+    keys = js_malloc(ctx, sizeof(*keys) + names.size);
+    if (!keys)
+        goto fail;
+    keys->shape = js_dup_shape(sh);
+    keys->is_plain = is_plain;
+    keys->is_ascii = (str8_find_non_ascii(names.buf, names.size) == names.size);
+    keys->offsets = offsets;
+    keys->names = (uint8_t *)(keys + 1);
+    memcpy(keys->names, names.buf, names.size);
+    dbuf_free(&names);
+    json_free_shape_keys(rt, *pcache);
+    *pcache = keys;
+ done:
+    if (keys->is_plain)
+        *pkeys = keys;
+    return 0;
+ fail:
+    js_free(ctx, offsets);
+    dbuf_free(&names);
+    JS_ThrowOutOfMemory(ctx);
+    return -1;
+}
+
+/* return 0 if OK, -1 if exception, 1 to give up */
+static int json_fast_to_str(JSONFastState *s, JSValueConst val);
+
+static int json_fast_to_str_object(JSONFastState *s, JSObject *p)
+{
+    JSONShapeKeys *keys;
+    JSValue v;
+    JSAtom atom;
+    uint32_t i, len;
+    BOOL has_content;
+    int ret;
+
+    if (json_get_shape_keys(s->ctx, p->shape, &keys))
+        return -1;
+    if (!keys)
+        return 1;
+    json_fast_putc(s, '{');
+    has_content = FALSE;
+    for(i = 0; i < p->shape->prop_count; i++) {
+        len = keys->offsets[i + 1] - keys->offsets[i];
+        if (len == 0)
+            continue;
+        v = p->prop[i].u.value;
+        /* undefined, functions and symbols are skipped */
+        if (JS_IsUndefined(v) || JS_VALUE_GET_TAG(v) == JS_TAG_SYMBOL ||
+            JS_IsFunction(s->ctx, v))
+            continue;
+        if (has_content)
+            json_fast_putc(s, ',');
+        if (s->sb && !keys->is_ascii) {
+            atom = get_shape_prop(p->shape)[i].atom;
+            json_fast_put_quoted(s, s->ctx->rt->atom_array[atom]);
+            json_fast_putc(s, ':');
+        } else {
+            json_fast_put(s, (const char *)keys->names + keys->offsets[i],
+                          len);
+        }
+        ret = json_fast_to_str(s, v);
+        if (ret)
+            return ret;
+        /* the keys of the nested objects may have replaced 'keys' in
+           the cache */
+        if (JS_VALUE_GET_TAG(v) == JS_TAG_OBJECT) {
+            if (json_get_shape_keys(s->ctx, p->shape, &keys))
+                return -1;
+        }
+        has_content = TRUE;
+    }
+    json_fast_putc(s, '}');
+    return 0;
+}
+
+static int json_fast_to_str_array(JSONFastState *s, JSObject *p)
+{
+    JSValue v;
+    uint32_t i, len;
+    int ret;
+
+    if (JS_VALUE_GET_TAG(p->prop[0].u.value) != JS_TAG_INT)
+        return 1;
+    len = JS_VALUE_GET_INT(p->prop[0].u.value);
+    /* the holes after 'count' are looked up in the prototypes */
+    if (len > p->u.array.count)
+        return 1;
+    json_fast_putc(s, '[');
+    for(i = 0; i < len; i++) {
+        if (i > 0)
+            json_fast_putc(s, ',');
+        v = p->u.array.u.values[i];
+        if (JS_IsUndefined(v) || JS_VALUE_GET_TAG(v) == JS_TAG_SYMBOL ||
+            JS_IsFunction(s->ctx, v)) {
+            json_fast_puts(s, "null");
+        } else {
+            ret = json_fast_to_str(s, v);
+            if (ret)
+                return ret;
+        }
+    }
+    json_fast_putc(s, ']');
+    return 0;
+}
+
+static int json_fast_to_str(JSONFastState *s, JSValueConst val)
+{
+    JSContext *ctx = s->ctx;
+    char buf[JS_DTOA_BUF_SIZE];
+    JSObject *p;
+    double d;
+    int ret;
+
+    switch(JS_VALUE_GET_NORM_TAG(val)) {
+    case JS_TAG_STRING:
+        json_fast_put_quoted(s, JS_VALUE_GET_STRING(val));
+        break;
+    case JS_TAG_INT:
+        json_fast_put_int(s, JS_VALUE_GET_INT(val));
+        break;
+    case JS_TAG_FLOAT64:
+        d = JS_VALUE_GET_FLOAT64(val);
+        if (!isfinite(d)) {
+            json_fast_puts(s, "null");
+        } else {
+            js_dtoa1(buf, d, 10, 0, JS_DTOA_VAR_FORMAT);
+            json_fast_puts(s, buf);
+        }
+        break;
+    case JS_TAG_BOOL:
+        json_fast_puts(s, JS_VALUE_GET_BOOL(val) ? "true" : "false");
+        break;
+    case JS_TAG_NULL:
+        json_fast_puts(s, "null");
+        break;
+    case JS_TAG_OBJECT:
+        /* cycles also end here */
+        if (s->depth >= JSON_FAST_MAX_DEPTH ||
+            js_check_stack_overflow(ctx->rt, 0))
+            return 1;
+        p = JS_VALUE_GET_OBJ(val);
+        s->depth++;
+        if (p->class_id == JS_CLASS_OBJECT)
+            ret = json_fast_to_str_object(s, p);
+        else if (p->class_id == JS_CLASS_ARRAY && p->fast_array &&
+                 p->shape == ctx->array_shape)
+            ret = json_fast_to_str_array(s, p);
+        else
+            ret = 1;
+        s->depth--;
+        return ret;
+    default:
+        return 1;
+    }
+    return 0;
+}
+
+/* Write 'obj' to 'sb' or, if it is NULL, to 'b'. Return 0 if OK, -1
+   if exception, 1 if the generic algorithm must be used. */
+static int json_fast_stringify(JSContext *ctx, StringBuffer *sb, DynBuf *b,
+                               JSValueConst obj)
+{
+    JSONFastState s1, *s = &s1;
+    int ret;
+
+    if (JS_IsObject(obj) &&
+        (!json_proto_is_plain(JS_VALUE_GET_OBJ(ctx->class_proto[JS_CLASS_OBJECT])) ||
+         !json_proto_is_plain(JS_VALUE_GET_OBJ(ctx->class_proto[JS_CLASS_ARRAY]))))
+        return 1;
+    s->ctx = ctx;
+    s->sb = sb;
+    s->b = b;
+    s->depth = 0;
+    ret = json_fast_to_str(s, obj);
+    if (ret == 0) {
+        if (sb) {
+            if (sb->error_status)
+                ret = -1;
+        } else if (dbuf_error(b)) {
+            JS_ThrowOutOfMemory(ctx);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+static JSValue json_stringify_generic(JSContext *ctx, JSValueConst obj,
+                                      JSValueConst replacer,
+                                      JSValueConst space0)
 {
     StringBuffer b_s;
     JSONStringifyContext jsc_s, *jsc = &jsc_s;
@@ -44195,6 +46291,78 @@ done:
     return ret;
 }
 
+JSValue JS_JSONStringify(JSContext *ctx, JSValueConst obj,
+                         JSValueConst replacer, JSValueConst space0)
+{
+    StringBuffer b_s, *b = &b_s;
+    int res;
+
+    if ((JS_IsUndefined(replacer) || JS_IsNull(replacer)) &&
+        (JS_IsUndefined(space0) || JS_IsNull(space0))) {
+        string_buffer_init(ctx, b, 0);
+        res = json_fast_stringify(ctx, b, NULL, obj);
+        if (res == 0)
+            return string_buffer_end(b);
+        string_buffer_free(b);
+        if (res < 0)
+            return JS_EXCEPTION;
+    }
+    return json_stringify_generic(ctx, obj, replacer, space0);
+}
+
+/* Same as JS_JSONStringify(obj, undefined, undefined) but return a
+   zero terminated UTF-8 buffer which must be freed with js_free().
+   Values which have no JSON representation give "null". Return NULL
+   if exception. */
+char *JS_JSONStringifyUTF8(JSContext *ctx, size_t *plen, JSValueConst obj)
+{
+    DynBuf dbuf;
+    JSValue json;
+    const char *str;
+    char *buf;
+    size_t len;
+    int res;
+
+    js_dbuf_init(ctx, &dbuf);
+    res = json_fast_stringify(ctx, NULL, &dbuf, obj);
+    if (res == 0) {
+        if (dbuf_putc(&dbuf, '\0')) {
+            dbuf_free(&dbuf);
+            JS_ThrowOutOfMemory(ctx);
+            goto fail;
+        }
+        if (plen)
+            *plen = dbuf.size - 1;
+        return (char *)dbuf.buf;
+    }
+    dbuf_free(&dbuf);
+    if (res < 0)
+        goto fail;
+
+    json = json_stringify_generic(ctx, obj, JS_UNDEFINED, JS_UNDEFINED);
+    if (JS_IsException(json))
+        goto fail;
+    if (JS_IsUndefined(json))
+        json = JS_AtomToString(ctx, JS_ATOM_null);
+    str = JS_ToCStringLen(ctx, &len, json);
+    JS_FreeValue(ctx, json);
+    if (!str)
+        goto fail;
+    buf = js_malloc(ctx, len + 1);
+    if (buf)
+        memcpy(buf, str, len + 1);
+    JS_FreeCString(ctx, str);
+    if (!buf)
+        goto fail;
+    if (plen)
+        *plen = len;
+    return buf;
+ fail:
+    if (plen)
+        *plen = 0;
+    return NULL;
+}
+
 static JSValue js_json_stringify(JSContext *ctx, JSValueConst this_val,
                                  int argc, JSValueConst *argv)
 {
@@ -44220,6 +46388,8 @@ void JS_AddIntrinsicJSON(JSContext *ctx)
 
 /* Reflect */
 
+#ifndef CONFIG_NO_REFLECT
+
 static JSValue js_reflect_apply(JSContext *ctx, JSValueConst this_val,
                                 int argc, JSValueConst *argv)
 {
@@ -44386,6 +46556,8 @@ static const JSCFunctionListEntry js_reflect_obj[] = {
     JS_OBJECT_DEF("Reflect", js_reflect_funcs, countof(js_reflect_funcs), JS_PROP_WRITABLE | JS_PROP_CONFIGURABLE ),
 };
 
+#endif /* !CONFIG_NO_REFLECT */
+
 /* Proxy */
 
 static void js_proxy_finalizer(JSRuntime *rt, JSValue val)
@@ -51034,7 +53206,9 @@ void JS_AddIntrinsicBaseObjects(JSContext *ctx)
     JS_SetPropertyFunctionList(ctx, ctx->global_obj, js_math_obj, countof(js_math_obj));
 
     /* ES6 Reflect: create as autoinit object */
+#ifndef CONFIG_NO_REFLECT
     JS_SetPropertyFunctionList(ctx, ctx->global_obj, js_reflect_obj, countof(js_reflect_obj));
+#endif
 
     /* ES6 Symbol */
     ctx->class_proto[JS_CLASS_SYMBOL] = JS_NewObject(ctx);
@@ -53949,7 +56123,7 @@ void JS_AddIntrinsicAtomics(JSContext *ctx)
 
 #endif /* CONFIG_ATOMICS */
 
-void JS_AddIntrinsicTypedArrays(JSContext *ctx)
+static void js_add_intrinsic_typed_arrays(JSContext *ctx)
 {
     JSValue typed_array_base_proto, typed_array_base_func;
     JSValueConst array_buffer_func, shared_array_buffer_func;
@@ -54029,6 +56203,11 @@ void JS_AddIntrinsicTypedArrays(JSContext *ctx)
     JS_NewGlobalCConstructorOnly(ctx, "DataView",
                                  js_dataview_constructor, 1,
                                  ctx->class_proto[JS_CLASS_DATAVIEW]);
+}
+
+void JS_AddIntrinsicTypedArrays(JSContext *ctx)
+{
+    js_add_intrinsic_typed_arrays(ctx);
     /* Atomics */
 #ifdef CONFIG_ATOMICS
     JS_AddIntrinsicAtomics(ctx);
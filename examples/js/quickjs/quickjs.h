@@ -333,6 +333,24 @@ JSRuntime *JS_NewRuntime(void);
 void JS_SetRuntimeInfo(JSRuntime *rt, const char *info);
 void JS_SetMemoryLimit(JSRuntime *rt, size_t limit);
 void JS_SetGCThreshold(JSRuntime *rt, size_t gc_threshold);
+void JS_SetGCGenerational(JSRuntime *rt, JS_BOOL enable);
+
+typedef struct JSGCStats {
+    /* totals since the runtime creation. Times are in microseconds.
+       minor_gc_count counts the collections of the young generation
+       or of a GC slice. */
+    int64_t gc_count, minor_gc_count;
+    int64_t pause_time;
+    int64_t objects_scanned, objects_freed, bytes_freed;
+    /* last collection */
+    int64_t last_pause_time;
+    int64_t last_objects_scanned, last_objects_freed, last_bytes_freed;
+    int64_t threshold; /* current automatic GC threshold in bytes */
+} JSGCStats;
+
+void JS_GetGCStats(JSRuntime *rt, JSGCStats *s);
+void JS_SetGCSliceTime(JSRuntime *rt, int budget_us);
+int JS_GetGCSliceTime(JSRuntime *rt);
 /* use 0 to disable maximum stack size check */
 void JS_SetMaxStackSize(JSRuntime *rt, size_t stack_size);
 /* should be called when changing thread to update the stack top value
@@ -345,6 +363,7 @@ void JS_SetRuntimeOpaque(JSRuntime *rt, void *opaque);
 typedef void JS_MarkFunc(JSRuntime *rt, JSGCObjectHeader *gp);
 void JS_MarkValue(JSRuntime *rt, JSValueConst val, JS_MarkFunc *mark_func);
 void JS_RunGC(JSRuntime *rt);
+void JS_RunGCSlice(JSRuntime *rt, int budget_us);
 JS_BOOL JS_IsLiveObject(JSRuntime *rt, JSValueConst obj);
 
 JSContext *JS_NewContext(JSRuntime *rt);
@@ -410,6 +429,9 @@ typedef struct JSMemoryUsage {
     int64_t c_func_count, array_count;
     int64_t fast_array_count, fast_array_elements;
     int64_t binary_object_count, binary_object_size;
+    /* pages of the slab allocator used for the objects, shapes and
+       small strings */
+    int64_t slab_page_count, slab_size, slab_free_size;
 } JSMemoryUsage;
 
 void JS_ComputeMemoryUsage(JSRuntime *rt, JSMemoryUsage *s);
@@ -717,6 +739,8 @@ JS_BOOL JS_IsFunction(JSContext* ctx, JSValueConst val);
 JS_BOOL JS_IsConstructor(JSContext* ctx, JSValueConst val);
 JS_BOOL JS_SetConstructorBit(JSContext *ctx, JSValueConst func_obj, JS_BOOL val);
 
+JS_BOOL JS_IsSameValue(JSContext *ctx, JSValueConst op1, JSValueConst op2);
+
 JSValue JS_NewArray(JSContext *ctx);
 int JS_IsArray(JSContext *ctx, JSValueConst val);
 
@@ -810,6 +834,8 @@ JSValue JS_ParseJSON2(JSContext *ctx, const char *buf, size_t buf_len,
                       const char *filename, int flags);
 JSValue JS_JSONStringify(JSContext *ctx, JSValueConst obj,
                          JSValueConst replacer, JSValueConst space0);
+/* return a zero terminated UTF-8 buffer to be freed with js_free() */
+char *JS_JSONStringifyUTF8(JSContext *ctx, size_t *plen, JSValueConst obj);
 
 typedef void JSFreeArrayBufferDataFunc(JSRuntime *rt, void *opaque, void *ptr);
 JSValue JS_NewArrayBuffer(JSContext *ctx, uint8_t *buf, size_t len,
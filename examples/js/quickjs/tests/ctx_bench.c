@@ -0,0 +1,95 @@
+/*
+ * Runtime and context construction benchmark
+ *
+ * Usage: tests/ctx_bench [iterations]
+ *
+ * Creates a runtime and a context set up like the js.wasm CGI guest,
+ * runs a small script, then frees everything. The minimum time of each
+ * step and the memory allocated once the script has run are reported,
+ * for a script which uses almost no builtin and for one which uses the
+ * lazily created ones.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "../quickjs-libc.h"
+#include "../cutils.h"
+
+static const char *scripts[][2] = {
+    { "hello", "'Hello, world!'" },
+    { "lazy builtins",
+      "new Map().set(1, new Set([new Date(0)])).size +"
+      "new Uint8Array(new ArrayBuffer(8)).length" },
+};
+
+static double get_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void bench(const char *name, const char *script, int n)
+{
+    double t0, t1, t2, t3, t4, t_rt, t_ctx, t_eval, t_free;
+    JSMemoryUsage stats;
+    JSRuntime *rt;
+    JSContext *ctx;
+    JSValue val;
+    int i;
+
+    t_rt = t_ctx = t_eval = t_free = 1e9;
+    for(i = 0; i < n; i++) {
+        t0 = get_time_us();
+        rt = JS_NewRuntime();
+        js_std_init_handlers(rt);
+        t1 = get_time_us();
+        ctx = JS_NewContext(rt);
+        js_std_add_helpers(ctx, 0, NULL);
+        js_init_module_std(ctx, "std");
+        js_init_module_os(ctx, "os");
+        t2 = get_time_us();
+        val = JS_Eval(ctx, script, strlen(script), "<bench>",
+                      JS_EVAL_TYPE_GLOBAL);
+        if (JS_IsException(val)) {
+            js_std_dump_error(ctx);
+            exit(1);
+        }
+        JS_FreeValue(ctx, val);
+        t3 = get_time_us();
+        if (i == 0)
+            JS_ComputeMemoryUsage(rt, &stats);
+        js_std_free_handlers(rt);
+        JS_FreeContext(ctx);
+        JS_FreeRuntime(rt);
+        t4 = get_time_us();
+
+        if (t1 - t0 < t_rt)
+            t_rt = t1 - t0;
+        if (t2 - t1 < t_ctx)
+            t_ctx = t2 - t1;
+        if (t3 - t2 < t_eval)
+            t_eval = t3 - t2;
+        if (t4 - t3 < t_free)
+            t_free = t4 - t3;
+    }
+    printf("%-16s %8.1f %8.1f %8.1f %8.1f %8.1f %10" PRId64 " %8" PRId64 "\n",
+           name, t_rt, t_ctx, t_eval, t_free, t_rt + t_ctx + t_eval + t_free,
+           stats.malloc_size, stats.obj_count);
+}
+
+int main(int argc, char **argv)
+{
+    int i, n;
+
+    n = argc > 1 ? atoi(argv[1]) : 1000;
+    printf("%-16s %8s %8s %8s %8s %8s %10s %8s\n",
+           "script", "rt(us)", "ctx(us)", "eval(us)", "free(us)", "total",
+           "mem(B)", "objects");
+    for(i = 0; i < countof(scripts); i++)
+        bench(scripts[i][0], scripts[i][1], n);
+    return 0;
+}
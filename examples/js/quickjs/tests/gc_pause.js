@@ -0,0 +1,75 @@
+/*
+ * Garbage collector pause benchmark
+ *
+ * Usage: qjs --std [--gc-generational] [--gc-slice n] tests/gc_pause.js
+ *
+ * For each heap size, a live heap of records is allocated, then a loop
+ * allocates short lived cycles and some long lived ones. The maximum
+ * and total time spent in the automatic collections are reported.
+ */
+"use strict";
+
+function make_heap(n)
+{
+    var heap, i, r;
+    heap = [];
+    for(i = 0; i < n; i++) {
+        r = { id: i, name: "record" + i, tags: [ i, i + 1 ] };
+        r.self = r;
+        heap.push(r);
+    }
+    return heap;
+}
+
+function run(heap_size, iterations)
+{
+    var heap, st, count, count0, max_pause, pause0, i, a, b, old, freed0;
+
+    heap = make_heap(heap_size);
+    st = std.gcStats();
+    count0 = count = st.count;
+    pause0 = st.pauseTime;
+    freed0 = st.objectsFreed;
+    max_pause = 0;
+    old = [];
+    for(i = 0; i < iterations; i++) {
+        a = { i: i, body: "x" };
+        b = { a: a, headers: { "content-type": "text/plain" } };
+        a.b = b;
+        /* some cycles become old before being released */
+        if ((i % 100) == 0) {
+            old.push(a);
+            if (old.length > 100)
+                old.shift();
+        }
+        st = std.gcStats();
+        if (st.count != count) {
+            count = st.count;
+            if (st.lastPauseTime > max_pause)
+                max_pause = st.lastPauseTime;
+        }
+    }
+    st = std.gcStats();
+    print(("" + heap_size).padStart(10) +
+          ("" + (st.count - count0)).padStart(6) +
+          (max_pause / 1000).toFixed(3).padStart(12) +
+          ((st.pauseTime - pause0) / 1000).toFixed(3).padStart(12) +
+          ("" + (st.objectsFreed - freed0)).padStart(12));
+    heap = null;
+}
+
+function main()
+{
+    var sizes = [ 10000, 100000, 300000, 1000000 ];
+    var i;
+
+    print("heap objs".padStart(10) + "GCs".padStart(6) +
+          "max (ms)".padStart(12) + "total (ms)".padStart(12) +
+          "freed".padStart(12));
+    for(i = 0; i < sizes.length; i++) {
+        run(sizes[i], 1000000);
+        std.gc();
+    }
+}
+
+main();
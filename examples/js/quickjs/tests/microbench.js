@@ -228,6 +228,15 @@ function prop_create(n)
     return n * 4;
 }
 
+function prop_literal(n)
+{
+    var obj, j;
+    for(j = 0; j < n; j++) {
+        obj = { statusCode: j, headers: null, body: "", isBase64Encoded: false };
+    }
+    return n * 4;
+}
+
 function prop_delete(n)
 {
     var obj, j;
@@ -740,6 +749,187 @@ function string_build4(n)
     return n * 100;
 }
 
+/* incremental string construction with template literals, as done by
+   request handlers building HTML */
+function string_build_template(n)
+{
+    var i, r;
+    r = "";
+    for(i = 0; i < n; i++)
+        r += `<li>${i}</li>`;
+    global_res = r;
+    return n;
+}
+
+/* incremental string construction of a long string */
+function string_build_long(n)
+{
+    var i, r;
+    r = "";
+    for(i = 0; i < n * 100; i++)
+        r += "xyz";
+    global_res = r;
+    return n * 100;
+}
+
+/* search in a long string, as done when parsing request payloads */
+function string_index_of(n)
+{
+    var s, i, j, r;
+    s = "abcdefghijklmnopqrstuvwxyz ".repeat(40) + "needle";
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += s.indexOf("needle");
+        r += s.indexOf("\n");
+        r += s.includes("z!") ? 1 : 0;
+    }
+    global_res = r;
+    return n * 3;
+}
+
+/* routing and validation of request paths and headers with regexps */
+function regexp_route(n)
+{
+    var routes, paths, j, k, l, r;
+    routes = [ /^\/api\/v1\/users\/(\d+)$/,
+               /^\/api\/v1\/users\/(\d+)\/orders(?:\/(\d+))?$/,
+               /^\/api\/v1\/products\/([a-z0-9-]+)$/,
+               /^\/health$/ ];
+    paths = [ "/api/v1/users/42", "/api/v1/users/42/orders/7",
+              "/api/v1/products/blue-widget-3", "/health", "/api/v2/unknown" ];
+    r = 0;
+    for(j = 0; j < n; j++) {
+        for(k = 0; k < paths.length; k++) {
+            for(l = 0; l < routes.length; l++) {
+                if (routes[l].test(paths[k])) {
+                    r++;
+                    break;
+                }
+            }
+        }
+        r += /^[^@\s]+@[^@\s]+\.[a-z]+$/i.test("john.doe@example.com") ? 1 : 0;
+    }
+    global_res = r;
+    return n * 6;
+}
+
+/* unanchored regexp search in a long string */
+function regexp_search(n)
+{
+    var s, j, r;
+    s = "GET /index.html HTTP/1.1 host=example.com agent=test ".repeat(20) +
+        "status=404 request_id=5e3b1d2a-9f2c";
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += s.search(/status=(\d+)/);
+        r += s.search(/request_id=[0-9a-f]{8}-/);
+        r += /\berror\b/i.test(s) ? 1 : 0;
+    }
+    global_res = r;
+    return n * 3;
+}
+
+/* JSON.stringify of mostly unescaped strings */
+function json_stringify_string(n)
+{
+    var a, s8, s16, j, r;
+    s8 = "The quick brown fox jumps over the lazy dog. ".repeat(20);
+    s16 = "\u00e9t\u00e9 \u4e2d\u6587 text ".repeat(40);
+    a = [ s8, s16, s8 + "\"quoted\"\n" ];
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += JSON.stringify(a).length;
+    }
+    global_res = r;
+    return n;
+}
+
+/* JSON.stringify of a lambda response with a list of records */
+function json_stringify_response(n)
+{
+    var items, res, i, j, r;
+    items = [];
+    for(i = 0; i < 20; i++)
+        items.push({ id: i, name: "item" + i, price: i * 1.25, tags: [ "a", "b" ], available: true });
+    res = {
+        statusCode: 200,
+        headers: { "content-type": "application/json", "cache-control": "no-cache" },
+        body: { items: items, total: 20, next: null }
+    };
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += JSON.stringify(res).length;
+    }
+    global_res = r;
+    return n;
+}
+
+/* JSON.parse of an API Gateway style lambda event */
+function json_parse_event(n)
+{
+    var ev, s, j, r;
+    ev = {
+        version: "2.0",
+        routeKey: "$default",
+        rawPath: "/api/v1/users/42",
+        rawQueryString: "include=orders&limit=20",
+        headers: {
+            "accept": "application/json",
+            "accept-encoding": "gzip, deflate, br",
+            "content-length": "87",
+            "content-type": "application/json",
+            "host": "abcdef1234.execute-api.us-east-1.amazonaws.com",
+            "user-agent": "Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/115.0",
+            "x-amzn-trace-id": "Root=1-5e3b1d2a-9f2c4a8b7e6d5c4b3a291807",
+            "x-forwarded-for": "203.0.113.17",
+            "x-forwarded-port": "443",
+            "x-forwarded-proto": "https"
+        },
+        queryStringParameters: { include: "orders", limit: "20" },
+        requestContext: {
+            accountId: "123456789012",
+            apiId: "abcdef1234",
+            domainName: "abcdef1234.execute-api.us-east-1.amazonaws.com",
+            http: {
+                method: "POST",
+                path: "/api/v1/users/42",
+                protocol: "HTTP/1.1",
+                sourceIp: "203.0.113.17",
+                userAgent: "Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101 Firefox/115.0"
+            },
+            requestId: "JKJaXmPLvHcESHA=",
+            stage: "$default",
+            time: "10/Mar/2020:00:03:59 +0000",
+            timeEpoch: 1583798639428
+        },
+        body: "{\"name\":\"Jane Doe\",\"email\":\"jane@example.com\",\"tags\":[\"a\",\"b\"]}",
+        isBase64Encoded: false
+    };
+    s = JSON.stringify(ev);
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += JSON.parse(s).requestContext.timeEpoch;
+    }
+    global_res = r;
+    return n;
+}
+
+/* JSON.parse of an array of records sharing the same keys */
+function json_parse_records(n)
+{
+    var a, s, i, j, r;
+    a = [];
+    for(i = 0; i < 100; i++)
+        a.push({ id: i, name: "user" + i, active: (i & 1) == 0, score: i * 1.5 });
+    s = JSON.stringify(a);
+    r = 0;
+    for(j = 0; j < n; j++) {
+        r += JSON.parse(s).length;
+    }
+    global_res = r;
+    return n * 100;
+}
+
 /* sort bench */
 
 function sort_bench(text) {
@@ -958,6 +1148,7 @@ function main(argc, argv, g)
         prop_read,
         prop_write,
         prop_create,
+        prop_literal,
         prop_delete,
         array_read,
         array_write,
@@ -987,6 +1178,15 @@ function main(argc, argv, g)
         string_build2,
         //string_build3,
         //string_build4,
+        string_build_template,
+        string_build_long,
+        string_index_of,
+        regexp_route,
+        regexp_search,
+        json_stringify_string,
+        json_stringify_response,
+        json_parse_event,
+        json_parse_records,
         sort_bench,
         int_to_string,
         float_to_string,
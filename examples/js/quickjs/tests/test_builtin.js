@@ -479,6 +479,142 @@ function test_json()
 ]`);
 }
 
+function test_json_parse()
+{
+    var a, b, s, i;
+
+    /* the last duplicate property wins */
+    a = JSON.parse('{"x":1,"y":2,"x":3}');
+    assert(Object.keys(a), ["x", "y"]);
+    assert(a.x, 3);
+
+    /* "__proto__" is an own property */
+    a = JSON.parse('{"__proto__":{"x":1},"y":2}');
+    assert(Object.getPrototypeOf(a), Object.prototype);
+    assert(Object.keys(a), ["__proto__", "y"]);
+    assert(a.__proto__.x, 1);
+    assert(a.x, undefined);
+
+    /* integer keys */
+    a = JSON.parse('{"b":1,"2":2,"a":3,"1":4,"4294967295":5}');
+    assert(Object.keys(a), ["1", "2", "b", "a", "4294967295"]);
+    assert(a[1], 4);
+    assert(a["4294967295"], 5);
+
+    /* numbers */
+    assert(Object.is(JSON.parse("-0"), -0));
+    assert(Object.is(JSON.parse("[-0]")[0], -0));
+    assert(JSON.parse("0"), 0);
+    assert(JSON.parse("999999999"), 999999999);
+    assert(JSON.parse("-99999999"), -99999999);
+    assert(JSON.parse("-999999999"), -999999999);
+    assert(JSON.parse("2147483648"), 2147483648);
+    assert(JSON.parse("-2147483649"), -2147483649);
+    assert(JSON.parse("12345678901234567890"), 12345678901234567890);
+    assert(JSON.parse("1.5e3"), 1500);
+    assert(JSON.parse("-1E-2"), -0.01);
+    assert_throws(SyntaxError, () => JSON.parse("01"));
+    assert_throws(SyntaxError, () => JSON.parse("-"));
+
+    /* escapes */
+    assert(JSON.parse('"\\"\\\\\\/\\b\\f\\n\\r\\t"'), "\"\\/\b\f\n\r\t");
+    assert(JSON.parse('"\\u0041\\u00e9\\u20ac\\ud83d\\ude00"'), "Aé€😀");
+    assert(JSON.parse('{"\\u0078":1}').x, 1);
+    assert_throws(SyntaxError, () => JSON.parse('"\\u00"'));
+    assert_throws(SyntaxError, () => JSON.parse('"a\nb"'));
+
+    /* characters which are not valid UTF-8 once converted */
+    assert(JSON.parse('"é€😀"'), "é€😀");
+    a = JSON.parse('"\ud800x\udc00"');
+    assert(a.length, 3);
+    assert(a.charCodeAt(0), 0xd800);
+    assert(a.charCodeAt(2), 0xdc00);
+    assert(JSON.parse('{"\udfff":1}')["\udfff"], 1);
+
+    /* deep nesting */
+    s = "[".repeat(1000) + "]".repeat(1000);
+    assert(JSON.stringify(JSON.parse(s)), s);
+    s = "[".repeat(1000000) + "]".repeat(1000000);
+    assert_throws(SyntaxError, () => JSON.parse(s));
+    s = '{"a":'.repeat(1000000) + "1" + "}".repeat(1000000);
+    assert_throws(SyntaxError, () => JSON.parse(s));
+
+    /* the objects created from a cached shape are not affected by the
+       changes of the previous ones */
+    s = '{"x":1,"y":2}';
+    for(i = 0; i < 2; i++) {
+        a = JSON.parse(s);
+        Object.defineProperty(a, "x", { writable: false });
+        delete a.y;
+        a.z = 3;
+        Object.freeze(a);
+    }
+    b = JSON.parse(s);
+    assert(Object.keys(b), ["x", "y"]);
+    b.x = 4;
+    b.y = 5;
+    b.w = 6;
+    delete b.x;
+    assert(JSON.stringify(b), '{"y":5,"w":6}');
+    assert(JSON.stringify(a), '{"x":1,"z":3}');
+}
+
+function test_json_stringify()
+{
+    var a, s, i, v;
+
+    /* toJSON() is used even if it is not enumerable */
+    a = { x: 1 };
+    Object.defineProperty(a, "toJSON", { value: function() { return "X"; } });
+    assert(JSON.stringify(a), '"X"');
+    assert(JSON.stringify([a]), '["X"]');
+    a = { x: 1 };
+    Object.defineProperty(a, "toJSON", { get: function() { return () => "G"; } });
+    assert(JSON.stringify({ a: a }), '{"a":"G"}');
+    a = Object.create({ toJSON: function() { return 1; } });
+    assert(JSON.stringify(a), "1");
+
+    /* getters */
+    a = { get x() { return 1; }, y: 2 };
+    assert(JSON.stringify(a), '{"x":1,"y":2}');
+    a = { y: 2 };
+    Object.defineProperty(a, "x", { get: function() { return 1; } });
+    assert(JSON.stringify(a), '{"y":2}');
+
+    /* the nested objects have enough shapes for their cached keys to
+       replace the ones of the enclosing object */
+    a = {};
+    s = [];
+    for(i = 0; i < 1000; i++) {
+        v = {};
+        v["k" + i] = i;
+        a["p" + i] = v;
+        s.push('"p' + i + '":{"k' + i + '":' + i + '}');
+    }
+    assert(JSON.stringify(a), "{" + s.join(",") + "}");
+
+    /* lone surrogates are escaped */
+    assert(JSON.stringify("\ud800"), '"\\ud800"');
+    assert(JSON.stringify({ "\udc00": "a\udfffb" }), '{"\\udc00":"a\\udfffb"}');
+    assert(JSON.stringify(["😀", "\ude00\ud83d"]),
+           '["😀","\\ude00\\ud83d"]');
+
+    /* the holes of an array are looked up in its prototypes */
+    a = [0];
+    a.length = 3;
+    assert(JSON.stringify(a), "[0,null,null]");
+    Array.prototype[1] = 5;
+    assert(JSON.stringify(a), "[0,5,null]");
+    delete Array.prototype[1];
+    Object.prototype[2] = 6;
+    assert(JSON.stringify(a), "[0,null,6]");
+    delete Object.prototype[2];
+    Object.defineProperty(Array.prototype, 1, { get: function() { return 7; },
+                                                configurable: true });
+    assert(JSON.stringify(a), "[0,7,null]");
+    delete Array.prototype[1];
+}
+
 function test_date()
 {
     var d = new Date(1506098258091), a, s;
@@ -539,6 +675,21 @@ function test_regexp()
     assert(/{1a}/.toString(), "/{1a}/");
     a = /a{1+/.exec("a{11");
     assert(a, ["a{11"] );
+
+    /* start position filters */
+    a = /b(c)/.exec("abacbc");
+    assert(a.index === 4 && a[1] === "c");
+    assert(/ſ/i.exec("sſ").index, 1);
+    assert(/K/iu.exec("kK").index, 0);
+    assert(/\udc00/u.exec("𐀀"), null);
+    assert(/\udc00/.exec("𐀀").index, 1);
+    assert(/[\u{10000}-\u{10010}]/u.exec("a\u{10005}").index, 1);
+    a = /^a/g;
+    a.lastIndex = 1;
+    assert(a.exec("aa"), null);
+    assert(/^b/m.exec("a\nb").index, 2);
+    assert(/x*/.exec("abc").index, 0);
+    assert(/(?<=a)b/.exec("bab").index, 2);
 }
 
 function test_symbol()
@@ -677,6 +828,8 @@ test_number();
 test_eval();
 test_typed_array();
 test_json();
+test_json_parse();
+test_json_stringify();
 test_date();
 test_regexp();
 test_symbol();
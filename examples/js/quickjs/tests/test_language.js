@@ -359,6 +359,100 @@ function test_object_literal()
     assert(JSON.stringify(a), '{"x":0,"get":1,"set":2,"async":3}');
 }
 
+function test_object_literal_template()
+{
+    var a, b, r, it, log, i, s, __proto__;
+
+    function mk(v) { return { a: v, b: 2 }; }
+    function f(v) { log.push(v); return v; }
+    function t() { log.push("throw"); throw "err"; }
+
+    /* the objects do not share their changes */
+    a = mk(1);
+    a.c = 3;
+    delete a.a;
+    Object.freeze(a);
+    b = mk(4);
+    b.a = 5;
+    b.d = 6;
+    assert(JSON.stringify(a), '{"b":2,"c":3}');
+    assert(JSON.stringify(b), '{"a":5,"b":2,"d":6}');
+
+    /* duplicate names */
+    a = { x: 1, y: 2, x: 3 };
+    assert(JSON.stringify(a), '{"x":3,"y":2}');
+    r = 4;
+    a = { r: 1, y: 2, r };
+    assert(JSON.stringify(a), '{"r":4,"y":2}');
+
+    /* only the shorthand __proto__ defines a property */
+    b = { z: 1 };
+    __proto__ = b;
+    a = { __proto__, x: 1 };
+    assert(Object.getPrototypeOf(a), Object.prototype);
+    assert(Object.getOwnPropertyNames(a), ["__proto__", "x"]);
+    assert(a.__proto__, b);
+    a = { "__proto__": b, x: 1 };
+    assert(Object.getPrototypeOf(a), b);
+    assert(Object.getOwnPropertyNames(a), ["x"]);
+    a = { x: 1, __proto__: b };
+    assert(Object.getPrototypeOf(a), b);
+    assert(a.z, 1);
+
+    /* the values are evaluated in order, up to an exception */
+    log = [];
+    a = null;
+    try {
+        a = { x: f(1), y: t(), z: f(3) };
+    } catch(e) {
+        log.push(e);
+    }
+    assert(a, null);
+    assert(log.join(), "1,throw,err");
+
+    /* function names */
+    a = { f: function() {}, g: () => 1, c: class {} };
+    assert(a.f.name, "f");
+    assert(a.g.name, "g");
+    assert(a.c.name, "c");
+
+    /* yield and await in the values */
+    function *gen() { return { x: yield 1, y: yield 2, z: 3 }; }
+    it = gen();
+    it.next();
+    it.next("a");
+    r = it.next("b");
+    assert(JSON.stringify(r.value), '{"x":"a","y":"b","z":3}');
+    it = gen();
+    it.next();
+    r = it.return(4);
+    assert(r.value, 4);
+
+    async function af(p) { return { x: await p, y: 2 }; }
+    af(Promise.resolve(1)).then(function(v) {
+        assert(JSON.stringify(v), '{"x":1,"y":2}');
+    });
+
+    /* many fields */
+    for(i = 31; i <= 34; i++) {
+        s = [];
+        for(r = 0; r < i; r++)
+            s.push("f" + r + ":" + r);
+        a = eval("({" + s.join(",") + "})");
+        s = [];
+        for(r = 0; r < i; r++)
+            s.push('"f' + r + '":' + r);
+        assert(JSON.stringify(a), "{" + s.join(",") + "}");
+    }
+    a = { a0: 0, a1: 1, a2: 2, a3: 3, a4: 4, a5: 5, a6: 6, a7: 7,
+          a8: 8, a9: 9, b0: 10, b1: 11, b2: 12, b3: 13, b4: 14, b5: 15,
+          b6: 16, b7: 17, b8: 18, b9: 19, c0: 20, c1: 21, c2: 22, c3: 23,
+          c4: 24, c5: 25, c6: 26, c7: 27, c8: 28, c9: 29, d0: 30, d1: 31,
+          d2: 32 };
+    assert(Object.keys(a).length, 33);
+    assert(a.d1 + a.d2, 63);
+}
+
 function test_regexp_skip()
 {
     var a, b;
@@ -538,6 +632,7 @@ test_class();
 test_template();
 test_template_skip();
 test_object_literal();
+test_object_literal_template();
 test_regexp_skip();
 test_labels();
 test_destructuring();
@@ -2,26 +2,71 @@ use crate::wasm;
 use axum::{
     body::{Body, Bytes, HttpBody},
     headers::HeaderName,
-    http::{
-        header::{CONTENT_LENGTH, CONTENT_TYPE},
-        HeaderValue, Request, StatusCode, Version,
-    },
+    http::{header::CONTENT_TYPE, HeaderValue, Request, StatusCode, Version},
     response::IntoResponse,
 };
+use bytes::Buf;
 use hyper::HeaderMap;
-use std::{convert::Infallible, env, fs::File, io::Read, str::FromStr};
+use std::{env, fs::File, io::Read, str::FromStr, sync::OnceLock};
 
 const SERVER_SOFTWARE: &str = "wgi";
 
+/// Builds a single `KEY=VALUE` entry in the layout WASI expects for `environ_get`.
+fn env_entry(key: &str, value: &[u8]) -> Vec<u8> {
+    let mut entry = Vec::with_capacity(key.len() + 1 + value.len());
+    entry.extend_from_slice(key.as_bytes());
+    entry.push(b'=');
+    entry.extend_from_slice(value);
+    entry
+}
+
+/// Like `env_entry`, for a value made of a fixed prefix and a per-request part, without
+/// growing the entry a second time.
+fn env_entry_with_prefix(key: &str, prefix: &[u8], value: &[u8]) -> Vec<u8> {
+    let mut entry = Vec::with_capacity(key.len() + 1 + prefix.len() + value.len());
+    entry.extend_from_slice(key.as_bytes());
+    entry.push(b'=');
+    entry.extend_from_slice(prefix);
+    entry.extend_from_slice(value);
+    entry
+}
+
+/// The current working directory, used as the prefix for `PATH_TRANSLATED`. It never changes
+/// while the server is running, so only resolve it once.
+fn document_root() -> &'static str {
+    static ROOT: OnceLock<String> = OnceLock::new();
+    ROOT.get_or_init(|| {
+        env::current_dir()
+            .unwrap()
+            .into_os_string()
+            .into_string()
+            .unwrap()
+    })
+}
+
+/// The part of the CGI environment that is identical for every request. WASI takes the
+/// environment as owned entries, so these are still copied into each request's.
+fn server_vars() -> &'static [Vec<u8>] {
+    static VARS: OnceLock<Box<[Vec<u8>]>> = OnceLock::new();
+    VARS.get_or_init(|| {
+        Box::new([
+            env_entry("GATEWAY_INTERFACE", b"CGI/1.1"),
+            env_entry("SERVER_SOFTWARE", SERVER_SOFTWARE.as_bytes()),
+            env_entry("SERVER_NAME", b"127.0.0.1"),
+            env_entry("SERVER_PORT", b"9000"),
+        ])
+    })
+}
+
 #[derive(Debug)]
 pub struct CgiResponse {
     status: StatusCode,
     headers: HeaderMap,
-    body: String,
+    body: Bytes,
 }
 
 impl CgiResponse {
-    pub fn new(status: StatusCode, headers: HeaderMap, body: String) -> Self {
+    pub fn new(status: StatusCode, headers: HeaderMap, body: Bytes) -> Self {
         Self {
             status,
             headers,
@@ -30,15 +75,17 @@ impl CgiResponse {
     }
 }
 
-impl FromStr for CgiResponse {
-    type Err = Infallible;
-
-    fn from_str(payload: &str) -> Result<Self, Self::Err> {
+impl From<Bytes> for CgiResponse {
+    /// Parses the output of a script. The body is a slice of `payload`, so it is not copied.
+    fn from(mut payload: Bytes) -> Self {
         let mut status = StatusCode::OK;
         let mut headers = HeaderMap::new();
 
-        let body = if let Some((header, body)) = payload.split_once("\n\n") {
-            for line in header.lines() {
+        if let Some(pos) = memchr::memmem::find(&payload, b"\n\n") {
+            let header = payload.split_to(pos);
+            payload.advance(2);
+
+            for line in String::from_utf8_lossy(&header).lines() {
                 if let Some((key, value)) = line.split_once(':') {
                     let value = value.trim_start();
                     if key.to_lowercase() == "status" {
@@ -51,18 +98,21 @@ impl FromStr for CgiResponse {
                     }
                 }
             }
+        }
 
-            body.to_string()
-        } else {
-            payload.to_string()
-        };
-
-        Ok(Self::new(status, headers, body))
+        Self::new(status, headers, payload)
     }
 }
 
 impl IntoResponse for CgiResponse {
-    fn into_response(self) -> axum::response::Response {
+    fn into_response(mut self) -> axum::response::Response {
+        // Keep the content type a `String` body would have had.
+        if !self.headers.contains_key(CONTENT_TYPE) {
+            self.headers.insert(
+                CONTENT_TYPE,
+                HeaderValue::from_static("text/plain; charset=utf-8"),
+            );
+        }
         (self.status, self.headers, self.body).into_response()
     }
 }
@@ -90,9 +140,61 @@ fn server_protocol(version: Version) -> Option<&'static str> {
     }
 }
 
-fn to_cgi_http_header(header: &HeaderName) -> String {
-    let header = header.as_str();
-    "HTTP_".to_string() + &header.to_ascii_uppercase().replace('-', "_")
+/// Maps the most common request headers straight to their CGI variable prefix, so the usual
+/// request never has to transform header names.
+fn interned_cgi_header(header: &HeaderName) -> Option<&'static str> {
+    use axum::http::header::*;
+
+    // CGI handles two HTTP headers specially. The CGI RFC also suggests we should not
+    // duplicate them with the HTTP_ prefix.
+    let prefix = match *header {
+        CONTENT_TYPE => "CONTENT_TYPE=",
+        CONTENT_LENGTH => "CONTENT_LENGTH=",
+        ACCEPT => "HTTP_ACCEPT=",
+        ACCEPT_CHARSET => "HTTP_ACCEPT_CHARSET=",
+        ACCEPT_ENCODING => "HTTP_ACCEPT_ENCODING=",
+        ACCEPT_LANGUAGE => "HTTP_ACCEPT_LANGUAGE=",
+        AUTHORIZATION => "HTTP_AUTHORIZATION=",
+        CACHE_CONTROL => "HTTP_CACHE_CONTROL=",
+        CONNECTION => "HTTP_CONNECTION=",
+        COOKIE => "HTTP_COOKIE=",
+        DNT => "HTTP_DNT=",
+        HOST => "HTTP_HOST=",
+        IF_MODIFIED_SINCE => "HTTP_IF_MODIFIED_SINCE=",
+        IF_NONE_MATCH => "HTTP_IF_NONE_MATCH=",
+        ORIGIN => "HTTP_ORIGIN=",
+        PRAGMA => "HTTP_PRAGMA=",
+        REFERER => "HTTP_REFERER=",
+        UPGRADE_INSECURE_REQUESTS => "HTTP_UPGRADE_INSECURE_REQUESTS=",
+        USER_AGENT => "HTTP_USER_AGENT=",
+        _ => return None,
+    };
+
+    Some(prefix)
+}
+
+fn to_cgi_http_header(header: &HeaderName, value: &HeaderValue) -> Vec<u8> {
+    let value = value.as_bytes();
+
+    if let Some(prefix) = interned_cgi_header(header) {
+        let mut entry = Vec::with_capacity(prefix.len() + value.len());
+        entry.extend_from_slice(prefix.as_bytes());
+        entry.extend_from_slice(value);
+        return entry;
+    }
+
+    // Header names are already lowercase ASCII, so we only have to shift the case and
+    // swap dashes for underscores.
+    let header = header.as_str().as_bytes();
+    let mut entry = Vec::with_capacity(5 + header.len() + 1 + value.len());
+    entry.extend_from_slice(b"HTTP_");
+    entry.extend(header.iter().map(|&c| match c {
+        b'-' => b'_',
+        c => c.to_ascii_uppercase(),
+    }));
+    entry.push(b'=');
+    entry.extend_from_slice(value);
+    entry
 }
 
 pub async fn handler(mut request: Request<Body>) -> impl IntoResponse {
@@ -114,52 +216,37 @@ pub async fn handler(mut request: Request<Body>) -> impl IntoResponse {
     }
 
     let query = request.uri().query();
-    let method = format!("{}", request.method());
-
-    let mut vars = vec![
-        ("GATEWAY_INTERFACE".into(), "CGI/1.1".into()),
-        ("SERVER_SOFTWARE".into(), SERVER_SOFTWARE.into()),
-        ("SERVER_NAME".into(), "127.0.0.1".into()),
-        ("SERVER_PORT".into(), "9000".into()),
-        (
-            "SERVER_PROTOCOL".into(),
-            server_protocol(request.version())
-                .expect("Unknown HTTP version")
-                .into(),
-        ),
-        ("REQUEST_METHOD".into(), method),
-        ("QUERY_STRING".into(), query.unwrap_or("").into()),
-        // ("REMOTE_HOST".into(), "todo".into()),
-    ];
-
-    if let Some(var) = path_info {
-        let translated = env::current_dir()
-            .unwrap()
-            .into_os_string()
-            .into_string()
-            .unwrap()
-            + var;
-
-        vars.push(("PATH_INFO".into(), var.to_string()));
-        vars.push(("PATH_TRANSLATED".into(), translated));
-    }
+    let method = request.method().as_str();
+    let protocol = server_protocol(request.version()).expect("Unknown HTTP version");
 
+    let server_vars = server_vars();
+    let mut vars = Vec::with_capacity(server_vars.len() + 6 + request.headers().len());
+    vars.extend_from_slice(server_vars);
     if let Some(var) = script_name {
-        vars.push(("SCRIPT_NAME".into(), "/".to_string() + var));
+        vars.push(env_entry_with_prefix("SCRIPT_NAME", b"/", var.as_bytes()));
     }
+    vars.push(env_entry("SERVER_PROTOCOL", protocol.as_bytes()));
+    vars.push(env_entry("REQUEST_METHOD", method.as_bytes()));
+    vars.push(env_entry("QUERY_STRING", query.unwrap_or("").as_bytes()));
+    // vars.push(env_entry("REMOTE_HOST", b"todo"));
 
-    vars.extend(request.headers().iter().map(|(header, value)| {
-        let value = value.to_str().unwrap();
+    if let Some(var) = path_info {
+        vars.push(env_entry("PATH_INFO", var.as_bytes()));
+        vars.push(env_entry_with_prefix(
+            "PATH_TRANSLATED",
+            document_root().as_bytes(),
+            var.as_bytes(),
+        ));
+    }
 
-        // CGI handles two HTTP headers specially. The CGI RFC also suggests we should not
-        // duplicate them with the HTTP_ prefix.
-        match header {
-            &CONTENT_TYPE => ("CONTENT_TYPE".into(), value.into()),
-            &CONTENT_LENGTH => ("CONTENT_LENGTH".into(), value.into()),
-            header => (to_cgi_http_header(header), value.into()),
-        }
-    }));
+    vars.extend(
+        request
+            .headers()
+            .iter()
+            .map(|(header, value)| to_cgi_http_header(header, value)),
+    );
 
+    let app = wasm::App::new(wasm, script_name.unwrap_or(""));
     let body = request
         .body_mut()
         .data()
@@ -168,5 +255,5 @@ pub async fn handler(mut request: Request<Body>) -> impl IntoResponse {
         .unwrap()
         .unwrap_or_else(Bytes::new);
 
-    wasm::App::new(wasm).run_cgi(&body, &vars).unwrap()
+    app.run_cgi(&body, vars).unwrap()
 }
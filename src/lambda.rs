@@ -1,81 +1,287 @@
 use crate::wasm;
 use axum::{body::Body, http::Request, response::IntoResponse};
-use hyper::Response;
 use hyper::{
-    http::header::{HeaderMap, HeaderName, HeaderValue},
-    Method, Uri,
+    body::{Bytes, Sender},
+    http::{header::HeaderMap, response::Builder},
+    Method, Response, StatusCode, Uri,
 };
-use serde::{Deserialize, Serialize};
+use serde::Deserialize;
 use std::{
     borrow::Cow,
+    cell::Cell,
     collections::HashMap,
     fs::File,
-    io::Read,
+    io::{Read, Write},
     sync::{Arc, Mutex, MutexGuard},
 };
+use tokio::{runtime::Handle, sync::oneshot};
 use wasmer::{
     imports, Array, Function, ImportObject, LazyInit, Memory, Module, WasmCell, WasmPtr, WasmerEnv,
 };
 
-#[derive(Debug, Serialize)]
-#[serde(rename_all = "camelCase")]
+/// An API Gateway shaped event. Rather than collecting the request into an intermediate
+/// structure, the JSON is written straight from the hyper request parts.
+#[derive(Debug)]
 pub struct LambdaRequest<'a> {
-    resource: String,
-    path: String,
-    http_method: String,
-    headers: HashMap<&'a str, Vec<&'a str>>,
-    query_string_parameters: HashMap<&'a str, Vec<Cow<'a, str>>>,
-    path_parameters: Option<String>,
-    stage_variables: Option<String>,
-    body: Option<Cow<'a, str>>,
-    is_base64_encoded: bool,
+    method: &'a Method,
+    uri: &'a Uri,
+    headers: &'a HeaderMap,
+    body: &'a [u8],
 }
 
 impl<'a> LambdaRequest<'a> {
-    fn from(method: &'a Method, uri: &'a Uri, headermap: &'a HeaderMap, body: &'a [u8]) -> Self {
-        let query = uri.query();
+    pub fn new(method: &'a Method, uri: &'a Uri, headers: &'a HeaderMap, body: &'a [u8]) -> Self {
+        Self {
+            method,
+            uri,
+            headers,
+            body,
+        }
+    }
 
-        let mut headers: HashMap<&str, Vec<&str>> = Default::default();
-        for key in headermap.keys() {
-            let values: Result<Vec<&str>, _> = headermap
-                .get_all(key)
-                .iter()
-                .map(|value| value.to_str())
-                .collect();
-            headers.insert(key.as_str(), values.unwrap());
+    /// A rough upper bound of the serialized size, so the buffer rarely has to grow.
+    fn size_hint(&self) -> usize {
+        let headers: usize = self
+            .headers
+            .iter()
+            .map(|(key, value)| key.as_str().len() + value.len() + 8)
+            .sum();
+
+        256 + 2 * self.uri.path().len()
+            + 2 * self.uri.query().map_or(0, str::len)
+            + headers
+            + self.body.len() * 4 / 3
+    }
+
+    #[cfg(test)]
+    pub fn to_vec(&self) -> Vec<u8> {
+        let mut buf = Vec::new();
+        self.write_json(&mut buf);
+        buf
+    }
+
+    /// Replaces the contents of `buf` with the JSON event. `buf` keeps its allocation, so it
+    /// can be reused across requests.
+    pub fn write_json(&self, buf: &mut Vec<u8>) {
+        let path = self.uri.path();
+
+        buf.clear();
+        buf.reserve(self.size_hint());
+
+        buf.extend_from_slice(b"{\"resource\":");
+        write_json_str(buf, path);
+        buf.extend_from_slice(b",\"path\":");
+        write_json_str(buf, path);
+        buf.extend_from_slice(b",\"httpMethod\":");
+        write_json_str(buf, self.method.as_str());
+        buf.extend_from_slice(b",\"headers\":");
+        self.write_headers(buf);
+        buf.extend_from_slice(b",\"queryStringParameters\":");
+        self.write_query(buf);
+        buf.extend_from_slice(b",\"pathParameters\":null,\"stageVariables\":null,\"body\":");
+
+        let is_base64_encoded = match std::str::from_utf8(self.body) {
+            Ok(payload) => {
+                write_json_str(buf, payload);
+                false
+            }
+            Err(_) => {
+                buf.push(b'"');
+                {
+                    // The encoder borrows the buffer until it is dropped.
+                    let mut encoder =
+                        base64::write::EncoderWriter::new(&mut *buf, base64::STANDARD);
+                    encoder.write_all(self.body).unwrap();
+                    encoder.finish().unwrap();
+                }
+                buf.push(b'"');
+                true
+            }
+        };
+
+        if is_base64_encoded {
+            buf.extend_from_slice(b",\"isBase64Encoded\":true}");
+        } else {
+            buf.extend_from_slice(b",\"isBase64Encoded\":false}");
         }
+    }
 
-        let mut query_string_parameters: HashMap<&str, Vec<Cow<str>>> = Default::default();
-        if let Some(query) = query {
-            let qs: Vec<(&str, Cow<str>)> = serde_urlencoded::from_str(query).unwrap();
+    fn write_headers(&self, buf: &mut Vec<u8>) {
+        buf.push(b'{');
+        for (i, key) in self.headers.keys().enumerate() {
+            if i > 0 {
+                buf.push(b',');
+            }
 
-            for (key, value) in qs {
-                query_string_parameters
-                    .entry(key)
-                    .or_insert_with(|| vec![value]);
+            write_json_str(buf, key.as_str());
+            buf.extend_from_slice(b":[");
+            for (j, value) in self.headers.get_all(key).iter().enumerate() {
+                if j > 0 {
+                    buf.push(b',');
+                }
+                write_json_str(buf, &String::from_utf8_lossy(value.as_bytes()));
             }
+            buf.push(b']');
         }
+        buf.push(b'}');
+    }
 
-        let (body, is_base64_encoded) = match std::str::from_utf8(body) {
-            Ok(payload) => (payload.into(), false),
-            Err(_) => (base64::encode(body).into(), true),
-        };
+    fn write_query(&self, buf: &mut Vec<u8>) {
+        let params = self.query_params();
 
-        let path = uri.path().to_string();
-        Self {
-            resource: path.clone(),
-            path,
-            http_method: method.to_string(),
-            headers,
-            query_string_parameters,
-            path_parameters: Default::default(),
-            stage_variables: Default::default(),
-            body: Some(body),
-            is_base64_encoded,
+        buf.push(b'{');
+        for (i, (key, values)) in group_params(&params).into_iter().enumerate() {
+            if i > 0 {
+                buf.push(b',');
+            }
+
+            write_json_str(buf, key);
+            buf.extend_from_slice(b":[");
+            for (j, value) in values.into_iter().enumerate() {
+                if j > 0 {
+                    buf.push(b',');
+                }
+                write_json_str(buf, value);
+            }
+            buf.push(b']');
+        }
+        buf.push(b'}');
+    }
+
+    fn query_params(&self) -> Vec<(Cow<str>, Cow<str>)> {
+        match self.uri.query() {
+            Some(query) => serde_urlencoded::from_str(query).unwrap(),
+            None => Vec::new(),
+        }
+    }
+
+    /// Serializes the event in the binary layout served by the `lambda1` imports. See
+    /// `lambda_event_header` in `examples/js/lambda.h` for the layout.
+    #[cfg(test)]
+    pub fn to_binary(&self) -> Vec<u8> {
+        let mut buf = Vec::new();
+        self.write_binary(&mut buf);
+        buf
+    }
+
+    /// Like `write_json`, for the binary layout.
+    pub fn write_binary(&self, buf: &mut Vec<u8>) {
+        let params = self.query_params();
+        let params = group_params(&params);
+        let param_count: usize = params.iter().map(|(_, values)| values.len()).sum();
+
+        let mut event = BinaryEvent::new(buf, self.headers.len(), param_count, self.size_hint());
+
+        let body_utf8 = std::str::from_utf8(self.body).is_ok();
+        event.set_u32(BINARY_EVENT_FLAGS, if body_utf8 { BODY_UTF8 } else { 0 });
+
+        let method = event.push(self.method.as_str().as_bytes());
+        event.set_slice(BINARY_EVENT_METHOD, method);
+        let path = event.push(self.uri.path().as_bytes());
+        event.set_slice(BINARY_EVENT_PATH, path);
+        let body = event.push(self.body);
+        event.set_slice(BINARY_EVENT_BODY, body);
+
+        // HeaderMap yields every value of a header back to back, so repeated headers end up
+        // as adjacent pairs.
+        for (key, value) in self.headers.iter() {
+            event.push_pair(key.as_str().as_bytes(), value.as_bytes());
+        }
+
+        for (key, values) in params {
+            for value in values {
+                event.push_pair(key.as_bytes(), value.as_bytes());
+            }
         }
     }
 }
 
+/// Groups repeated query keys together, in order of first appearance.
+fn group_params<'p>(params: &'p [(Cow<str>, Cow<str>)]) -> Vec<(&'p str, Vec<&'p str>)> {
+    let mut index: HashMap<&str, usize> = HashMap::with_capacity(params.len());
+    let mut groups: Vec<(&str, Vec<&str>)> = Vec::with_capacity(params.len());
+    for (key, value) in params {
+        let i = *index.entry(key.as_ref()).or_insert_with(|| {
+            groups.push((key.as_ref(), Vec::new()));
+            groups.len() - 1
+        });
+        groups[i].1.push(value.as_ref());
+    }
+    groups
+}
+
+const BINARY_EVENT_VERSION: u32 = 1;
+const BODY_UTF8: u32 = 1 << 0;
+
+// Byte offsets of the fields in the fixed size event header.
+const BINARY_EVENT_FLAGS: usize = 4;
+const BINARY_EVENT_METHOD: usize = 8;
+const BINARY_EVENT_PATH: usize = 16;
+const BINARY_EVENT_BODY: usize = 24;
+const BINARY_EVENT_HEADERS: usize = 32;
+const BINARY_EVENT_QUERY: usize = 40;
+const BINARY_EVENT_HEADER_LEN: usize = 48;
+const BINARY_EVENT_PAIR_LEN: usize = 16;
+
+/// Builds a binary event: a fixed header, followed by the header and query pair tables, then
+/// the string data they point into. All integers are little endian `u32`s, and all offsets are
+/// relative to the start of the event.
+struct BinaryEvent<'b> {
+    buf: &'b mut Vec<u8>,
+    next_pair: usize,
+}
+
+impl<'b> BinaryEvent<'b> {
+    fn new(buf: &'b mut Vec<u8>, header_count: usize, param_count: usize, data_len: usize) -> Self {
+        let headers = BINARY_EVENT_HEADER_LEN;
+        let query = headers + header_count * BINARY_EVENT_PAIR_LEN;
+        let data = query + param_count * BINARY_EVENT_PAIR_LEN;
+
+        buf.clear();
+        buf.reserve(data + data_len);
+        buf.resize(data, 0);
+
+        let mut event = Self {
+            buf,
+            next_pair: headers,
+        };
+        event.set_u32(0, BINARY_EVENT_VERSION);
+        event.set_slice(BINARY_EVENT_HEADERS, (headers, header_count));
+        event.set_slice(BINARY_EVENT_QUERY, (query, param_count));
+        event
+    }
+
+    fn set_u32(&mut self, pos: usize, value: u32) {
+        self.buf[pos..pos + 4].copy_from_slice(&value.to_le_bytes());
+    }
+
+    fn set_slice(&mut self, pos: usize, (offset, len): (usize, usize)) {
+        self.set_u32(pos, offset.try_into().unwrap());
+        self.set_u32(pos + 4, len.try_into().unwrap());
+    }
+
+    fn push(&mut self, data: &[u8]) -> (usize, usize) {
+        let offset = self.buf.len();
+        self.buf.extend_from_slice(data);
+        (offset, data.len())
+    }
+
+    fn push_pair(&mut self, name: &[u8], value: &[u8]) {
+        let pos = self.next_pair;
+        self.next_pair += BINARY_EVENT_PAIR_LEN;
+
+        let name = self.push(name);
+        let value = self.push(value);
+        self.set_slice(pos, name);
+        self.set_slice(pos + 8, value);
+    }
+}
+
+fn write_json_str(buf: &mut Vec<u8>, value: &str) {
+    // Writing into a Vec can not fail.
+    serde_json::to_writer(&mut *buf, value).unwrap();
+}
+
 #[derive(Debug, Deserialize, Clone)]
 #[serde(rename_all = "camelCase")]
 pub struct LambdaResponse {
@@ -88,19 +294,21 @@ pub struct LambdaResponse {
     is_base64_encoded: bool,
 }
 
+/// Starts a response from the status and multi-value headers a guest handed us. Invalid
+/// values surface as an error once the body is attached.
+fn response_builder(status_code: u16, headers: HashMap<String, Vec<String>>) -> Builder {
+    let mut builder = Response::builder().status(status_code);
+    for (key, values) in headers {
+        for value in values {
+            builder = builder.header(key.as_str(), value.as_str());
+        }
+    }
+    builder
+}
+
 impl From<LambdaResponse> for Response<Body> {
     fn from(response: LambdaResponse) -> Self {
-        let mut builder = Response::builder().status(response.status_code);
-
-        let headers = builder.headers_mut().unwrap();
-        for (key, values) in response.headers {
-            for value in values {
-                headers.append(
-                    HeaderName::from_bytes(key.as_bytes()).unwrap(),
-                    HeaderValue::from_bytes(value.as_bytes()).unwrap(),
-                );
-            }
-        }
+        let builder = response_builder(response.status_code, response.headers);
 
         let body = response.body.map_or_else(Body::empty, |body| {
             if response.is_base64_encoded {
@@ -121,33 +329,91 @@ impl IntoResponse for LambdaResponse {
     }
 }
 
+/// The layout the guest expects the event in, picked from the module's imports.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum EventFormat {
+    Json,
+    Binary,
+}
+
+impl EventFormat {
+    /// Guests opt into the binary layout by importing `lambda_event` from `lambda1`.
+    pub fn for_module(module: &Module) -> Self {
+        let binary = module
+            .imports()
+            .any(|import| import.module() == "lambda1" && import.name() == "lambda_event");
+
+        if binary {
+            Self::Binary
+        } else {
+            Self::Json
+        }
+    }
+}
+
+/// Hands the response back to the HTTP handler as soon as the guest sends or starts streaming
+/// one. The guest may keep running its event loop afterwards.
+pub type Responder = oneshot::Sender<Response<Body>>;
+
+/// Events larger than this are not kept around for the next request.
+const EVENT_BUF_MAX_CAPACITY: usize = 1024 * 1024;
+
+thread_local! {
+    /// The event buffer of the last request run on this thread. The guests run on the blocking
+    /// pool, so the next request on the thread usually reuses its allocation.
+    static EVENT_BUF: Cell<Vec<u8>> = Cell::new(Vec::new());
+}
+
 #[derive(Debug)]
 pub struct LambdaState {
     request: Vec<u8>,
-    pub(crate) response: Option<LambdaResponse>,
+    responder: Option<Responder>,
+    body: Option<Sender>,
 }
 
 #[derive(WasmerEnv, Clone)]
 pub struct Env {
     state: Arc<Mutex<LambdaState>>,
+    handle: Handle,
     #[wasmer(export)]
     memory: LazyInit<Memory>,
 }
 
 impl Env {
-    pub fn new(request: LambdaRequest) -> Self {
-        let request = serde_json::to_vec(&request).unwrap();
+    /// Must be called from within the tokio runtime, streamed chunks are sent through it.
+    pub fn new(request: LambdaRequest, format: EventFormat, responder: Responder) -> Self {
+        let mut buf = EVENT_BUF.with(Cell::take);
+        match format {
+            EventFormat::Json => request.write_json(&mut buf),
+            EventFormat::Binary => request.write_binary(&mut buf),
+        }
         let state = LambdaState {
-            request,
-            response: None,
+            request: buf,
+            responder: Some(responder),
+            body: None,
         };
 
         Self {
             state: Arc::new(Mutex::new(state)),
+            handle: Handle::current(),
             memory: LazyInit::new(),
         }
     }
 
+    /// Completes the invocation once the guest has exited: ends a streamed body, and fails the
+    /// request if no response was sent.
+    pub fn finish(&self) {
+        let mut state = self.state();
+        state.body = None;
+        // A guest which sent no response fails the request.
+        state.responder = None;
+
+        let buf = std::mem::take(&mut state.request);
+        if buf.capacity() <= EVENT_BUF_MAX_CAPACITY {
+            EVENT_BUF.with(|cell| cell.set(buf));
+        }
+    }
+
     pub fn state(&self) -> MutexGuard<LambdaState> {
         self.state.lock().unwrap()
     }
@@ -165,6 +431,13 @@ impl Env {
                 "lambda_event" => Function::new_native_with_env(store, self.clone(), event),
                 "lambda_event_size" => Function::new_native_with_env(store, self.clone(), event_size),
                 "lambda_send_response" => Function::new_native_with_env(store, self.clone(), send_response),
+                "lambda_response_start" => Function::new_native_with_env(store, self.clone(), response_start),
+                "lambda_response_write" => Function::new_native_with_env(store, self.clone(), response_write),
+                "lambda_response_finish" => Function::new_native_with_env(store, self.clone(), response_finish),
+            },
+            "lambda1" => {
+                "lambda_event" => Function::new_native_with_env(store, self.clone(), event),
+                "lambda_event_size" => Function::new_native_with_env(store, self.clone(), event_size),
             }
         }
     }
@@ -206,8 +479,14 @@ pub fn send_response(env: &Env, buf: WasmPtr<u8, Array>, buf_len: u32) -> i32 {
     let event = copy_from_wasm(&buf);
     match serde_json::from_slice::<LambdaResponse>(&event) {
         Ok(value) => {
-            let mut state = env.state();
-            state.response = Some(value);
+            let responder = match env.state().responder.take() {
+                Some(responder) => responder,
+                None => {
+                    eprintln!("Response was already sent");
+                    return -1;
+                }
+            };
+            let _ = responder.send(value.into());
             0
         }
         Err(err) => {
@@ -217,6 +496,85 @@ pub fn send_response(env: &Env, buf: WasmPtr<u8, Array>, buf_len: u32) -> i32 {
     }
 }
 
+/// Sends the status and headers right away, the body follows through `response_write`.
+/// `headers` is a JSON object of header names to lists of values.
+pub fn response_start(
+    env: &Env,
+    status_code: u32,
+    headers: WasmPtr<u8, Array>,
+    headers_len: u32,
+) -> i32 {
+    let memory = env.memory();
+    let headers = headers.deref(memory, 0, headers_len).unwrap();
+
+    let headers = match serde_json::from_slice(&copy_from_wasm(&headers)) {
+        Ok(headers) => headers,
+        Err(err) => {
+            eprintln!("Failed to parse: {}", err);
+            return -1;
+        }
+    };
+
+    let status_code = match u16::try_from(status_code) {
+        Ok(status_code) => status_code,
+        Err(_) => {
+            eprintln!("Invalid status code: {}", status_code);
+            return -1;
+        }
+    };
+
+    let mut state = env.state();
+    if state.responder.is_none() {
+        eprintln!("Response was already started");
+        return -1;
+    }
+
+    let (sender, body) = Body::channel();
+    let response = match response_builder(status_code, headers).body(body) {
+        Ok(response) => response,
+        Err(err) => {
+            eprintln!("Invalid response: {}", err);
+            return -1;
+        }
+    };
+
+    let responder = state.responder.take().unwrap();
+    let _ = responder.send(response);
+    state.body = Some(sender);
+    0
+}
+
+/// Appends a chunk to a streamed body, waiting until the client has room for it.
+pub fn response_write(env: &Env, buf: WasmPtr<u8, Array>, buf_len: u32) -> i32 {
+    let memory = env.memory();
+    let buf = buf.deref(memory, 0, buf_len).unwrap();
+    let chunk = Bytes::from(copy_from_wasm(&buf));
+
+    // The sender is taken out of the state while waiting, so that a slow client does not hold
+    // the state lock.
+    let mut sender = match env.state().body.take() {
+        Some(sender) => sender,
+        None => return -1,
+    };
+
+    match env.handle.block_on(sender.send_data(chunk)) {
+        Ok(()) => {
+            env.state().body = Some(sender);
+            0
+        }
+        // The client went away, drop the rest of the body.
+        Err(_) => -1,
+    }
+}
+
+pub fn response_finish(env: &Env) -> i32 {
+    let mut state = env.state();
+    match state.body.take() {
+        Some(_) => 0,
+        None => -1,
+    }
+}
+
 fn iter_path_splits(mut path: &str) -> impl Iterator<Item = (&str, &str)> {
     if path.as_bytes().get(0) == Some(&b'/') {
         path = &path[1..];
@@ -229,18 +587,18 @@ fn iter_path_splits(mut path: &str) -> impl Iterator<Item = (&str, &str)> {
         .chain(std::iter::once((path, "")))
 }
 
-pub async fn handler(request: Request<Body>) -> impl IntoResponse {
+pub async fn handler(request: Request<Body>) -> Response<Body> {
     let path = request.uri().path();
 
     let mut wasm = Vec::new();
-    // let mut script_name = None;
+    let mut script_name = "";
     // let mut path_info = None;
     let mut last_err = None;
 
     for (path, _rest) in iter_path_splits(path) {
         match File::open(path).and_then(|mut file| file.read_to_end(&mut wasm)) {
             Ok(_) => {
-                // script_name = Some(path);
+                script_name = path;
                 // path_info = Some(rest);
                 last_err = None;
                 break;
@@ -256,16 +614,236 @@ pub async fn handler(request: Request<Body>) -> impl IntoResponse {
         panic!("failed to load file: {:?}", err);
     }
 
-    let app = wasm::App::new(wasm);
+    let app = wasm::App::new(wasm, script_name);
 
-    let method = request.method().clone();
-    let uri = request.uri().clone();
-    let headers = request.headers().clone();
+    let (parts, body) = request.into_parts();
+    let body = hyper::body::to_bytes(body).await.unwrap();
 
-    let body = request.into_body();
-    let body = hyper::body::to_bytes(body).await.unwrap().to_vec();
+    // The guest runs to completion synchronously, so keep it off the async workers. That
+    // also lets a streamed response go out while the guest is still producing it.
+    let (responder, response) = oneshot::channel();
+    let span = tracing::Span::current();
+    tokio::task::spawn_blocking(move || {
+        let _enter = span.enter();
+
+        let request = LambdaRequest::new(&parts.method, &parts.uri, &parts.headers, &body);
+        if let Err(err) = app.run_lamba(request, responder) {
+            tracing::error!("lambda failed: {:?}", err);
+        }
+    });
+
+    response.await.unwrap_or_else(|_| {
+        Response::builder()
+            .status(StatusCode::BAD_GATEWAY)
+            .body(Body::empty())
+            .unwrap()
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Instant;
+
+    fn request_parts(query: &str) -> (Method, Uri, HeaderMap) {
+        let uri = format!("/index.wasm?{}", query).parse().unwrap();
+        (Method::GET, uri, HeaderMap::new())
+    }
+
+    fn read_u32(buf: &[u8], pos: usize) -> usize {
+        u32::from_le_bytes(buf[pos..pos + 4].try_into().unwrap()) as usize
+    }
 
-    let request = LambdaRequest::from(&method, &uri, &headers, &body);
-    let response = app.run_lamba(request).unwrap();
-    response.unwrap()
+    fn read_str(buf: &[u8], pos: usize) -> &str {
+        let (offset, len) = (read_u32(buf, pos), read_u32(buf, pos + 4));
+        std::str::from_utf8(&buf[offset..offset + len]).unwrap()
+    }
+
+    #[test]
+    fn repeated_query_keys_json() {
+        let (method, uri, headers) = request_parts("a=1&a=2&b=3");
+        let event = LambdaRequest::new(&method, &uri, &headers, b"").to_vec();
+
+        let event: serde_json::Value = serde_json::from_slice(&event).unwrap();
+        assert_eq!(
+            event["queryStringParameters"],
+            serde_json::json!({"a": ["1", "2"], "b": ["3"]})
+        );
+    }
+
+    #[test]
+    fn repeated_query_keys_binary() {
+        let (method, uri, headers) = request_parts("a=1&a=2&b=3");
+        let event = LambdaRequest::new(&method, &uri, &headers, b"").to_binary();
+
+        let (offset, len) = (
+            read_u32(&event, BINARY_EVENT_QUERY),
+            read_u32(&event, BINARY_EVENT_QUERY + 4),
+        );
+        let pairs: Vec<(&str, &str)> = (0..len)
+            .map(|i| offset + i * BINARY_EVENT_PAIR_LEN)
+            .map(|pos| (read_str(&event, pos), read_str(&event, pos + 8)))
+            .collect();
+        assert_eq!(pairs, [("a", "1"), ("a", "2"), ("b", "3")]);
+    }
+
+    /// The serialization this module replaced: the headers and query parameters are collected
+    /// into maps, then the whole event goes through serde.
+    #[derive(serde::Serialize)]
+    #[serde(rename_all = "camelCase")]
+    struct PreviousRequest<'a> {
+        resource: String,
+        path: String,
+        http_method: String,
+        headers: HashMap<&'a str, Vec<&'a str>>,
+        query_string_parameters: HashMap<&'a str, Vec<Cow<'a, str>>>,
+        path_parameters: Option<String>,
+        stage_variables: Option<String>,
+        body: Option<Cow<'a, str>>,
+        is_base64_encoded: bool,
+    }
+
+    fn previous_to_vec(method: &Method, uri: &Uri, headermap: &HeaderMap, body: &[u8]) -> Vec<u8> {
+        let mut headers: HashMap<&str, Vec<&str>> = HashMap::new();
+        for key in headermap.keys() {
+            let values = headermap.get_all(key).iter();
+            headers.insert(key.as_str(), values.map(|v| v.to_str().unwrap()).collect());
+        }
+
+        let mut query_string_parameters: HashMap<&str, Vec<Cow<str>>> = HashMap::new();
+        if let Some(query) = uri.query() {
+            let qs: Vec<(&str, Cow<str>)> = serde_urlencoded::from_str(query).unwrap();
+            for (key, value) in qs {
+                query_string_parameters
+                    .entry(key)
+                    .or_insert_with(|| vec![value]);
+            }
+        }
+
+        let (body, is_base64_encoded) = match std::str::from_utf8(body) {
+            Ok(payload) => (payload.into(), false),
+            Err(_) => (base64::encode(body).into(), true),
+        };
+
+        let path = uri.path().to_string();
+        serde_json::to_vec(&PreviousRequest {
+            resource: path.clone(),
+            path,
+            http_method: method.to_string(),
+            headers,
+            query_string_parameters,
+            path_parameters: None,
+            stage_variables: None,
+            body: Some(body),
+            is_base64_encoded,
+        })
+        .unwrap()
+    }
+
+    /// A browser-like POST: a dozen headers, a few distinct query parameters and a body.
+    fn sample_request(body: &[u8]) -> (Method, Uri, HeaderMap, Vec<u8>) {
+        let uri = "/wgi-bin/app.wasm/items?page=2&sort=name&filter=active&q=caf%C3%A9&limit=50"
+            .parse()
+            .unwrap();
+        let mut headers = HeaderMap::new();
+        for (key, value) in [
+            ("host", "localhost:3000"),
+            (
+                "user-agent",
+                "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101",
+            ),
+            (
+                "accept",
+                "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8",
+            ),
+            ("accept-language", "en-US,en;q=0.5"),
+            ("accept-encoding", "gzip, deflate, br"),
+            ("content-type", "application/json"),
+            ("origin", "http://localhost:3000"),
+            ("connection", "keep-alive"),
+            ("referer", "http://localhost:3000/items?page=1"),
+            (
+                "cookie",
+                "session=0123456789abcdef0123456789abcdef; theme=dark",
+            ),
+            ("sec-fetch-dest", "empty"),
+            ("sec-fetch-mode", "cors"),
+        ] {
+            headers.insert(key, value.parse().unwrap());
+        }
+        (Method::POST, uri, headers, body.to_vec())
+    }
+
+    #[test]
+    fn json_matches_previous_serialization() {
+        let text = br#"{"name":"caf\u00e9","tags":["a","b"]}"#;
+        for body in [&text[..], &[0xff, 0x00, 0x80, 0x7f][..]] {
+            let (method, uri, headers, body) = sample_request(body);
+            let event = LambdaRequest::new(&method, &uri, &headers, &body).to_vec();
+            let previous = previous_to_vec(&method, &uri, &headers, &body);
+
+            let event: serde_json::Value = serde_json::from_slice(&event).unwrap();
+            let previous: serde_json::Value = serde_json::from_slice(&previous).unwrap();
+            assert_eq!(event, previous);
+        }
+    }
+
+    /// Prints the time taken to serialize an event, by the previous path and by the current one
+    /// with a fresh or a reused buffer. Set `WGI_BENCH_ITERATIONS` and run with
+    /// `cargo test --release bench_events -- --nocapture` for meaningful numbers.
+    #[test]
+    fn bench_events() {
+        let iterations: u32 = std::env::var("WGI_BENCH_ITERATIONS")
+            .ok()
+            .and_then(|value| value.parse().ok())
+            .unwrap_or(100);
+
+        let text: Vec<u8> = br#"{"id":1,"name":"item","tags":["a","b","c"]},"#
+            .iter()
+            .copied()
+            .cycle()
+            .take(2048)
+            .collect();
+        let binary: Vec<u8> = (0..4096).map(|i| (i * 7 % 256) as u8).collect();
+
+        for (body_name, body) in [("text", &text), ("binary", &binary)] {
+            let (method, uri, headers, body) = sample_request(body);
+            let request = LambdaRequest::new(&method, &uri, &headers, &body);
+            let (mut json_buf, mut binary_buf) = (Vec::new(), Vec::new());
+
+            let mut runs: [(&str, Box<dyn FnMut() -> usize + '_>); 4] = [
+                (
+                    "previous",
+                    Box::new(|| previous_to_vec(&method, &uri, &headers, &body).len()),
+                ),
+                ("json", Box::new(|| request.to_vec().len())),
+                (
+                    "json, reused",
+                    Box::new(|| {
+                        request.write_json(&mut json_buf);
+                        json_buf.len()
+                    }),
+                ),
+                (
+                    "binary, reused",
+                    Box::new(|| {
+                        request.write_binary(&mut binary_buf);
+                        binary_buf.len()
+                    }),
+                ),
+            ];
+            for (name, serialize) in runs.iter_mut() {
+                let started = Instant::now();
+                for _ in 0..iterations {
+                    std::hint::black_box(serialize());
+                }
+                println!(
+                    "{} body, {}: {:?}/event",
+                    body_name,
+                    name,
+                    started.elapsed() / iterations
+                );
+            }
+        }
+    }
 }
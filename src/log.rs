@@ -0,0 +1,245 @@
+//! The pipeline carrying the output of the guests to `tracing`.
+//!
+//! The guests only push their lines into a bounded queue, which never blocks them: when it is
+//! full the lines are dropped and counted. A single background task drains the queue, applies
+//! the per-script rate limits and emits the lines that are left, so a noisy script neither
+//! stalls its request on the subscriber nor floods it.
+
+use crate::wasm::Logger;
+use bytes::Bytes;
+use std::{
+    collections::HashMap,
+    env,
+    sync::{
+        atomic::{AtomicU64, Ordering},
+        Arc, OnceLock,
+    },
+    time::{Duration, Instant},
+};
+use tokio::sync::mpsc;
+use tracing::{Level, Span};
+
+/// Number of log records which can be waiting for the background task.
+const QUEUE_CAPACITY: usize = 4096;
+
+static QUEUE: OnceLock<mpsc::Sender<Record>> = OnceLock::new();
+
+/// Lines which could not be queued since the last time it was reported.
+static DROPPED: AtomicU64 = AtomicU64::new(0);
+
+/// The limits applied to the output of each script.
+///
+/// - `WGI_LOG_RATE`: sustained number of lines per second, 100 by default.
+/// - `WGI_LOG_BURST`: number of lines which can be logged at once, 1000 by default.
+/// - `WGI_LOG_SAMPLE`: past the limit, one line in this many is still logged. 0 disables it
+///   and is the default.
+#[derive(Debug, Clone, Copy)]
+struct Limits {
+    rate: f64,
+    burst: f64,
+    sample: u64,
+}
+
+impl Limits {
+    fn from_env() -> Self {
+        fn var<T: std::str::FromStr>(name: &str, default: T) -> T {
+            env::var(name)
+                .ok()
+                .and_then(|value| value.parse().ok())
+                .unwrap_or(default)
+        }
+
+        Self {
+            rate: var("WGI_LOG_RATE", 100.0),
+            burst: var("WGI_LOG_BURST", 1000.0),
+            sample: var("WGI_LOG_SAMPLE", 0),
+        }
+    }
+}
+
+/// Starts the background task draining the guest logs. Until it is called, the lines are
+/// logged directly by the guest threads.
+pub fn spawn() {
+    let (sender, receiver) = mpsc::channel(QUEUE_CAPACITY);
+    if QUEUE.set(sender).is_ok() {
+        tokio::spawn(drain(receiver, Limits::from_env()));
+    }
+}
+
+/// Where a line comes from. `span` is the span of the request which ran the guest, the lines
+/// are emitted in it even though the background task drains them later.
+#[derive(Debug)]
+pub struct Source {
+    pub script: Arc<str>,
+    pub span: Span,
+}
+
+#[derive(Debug)]
+struct Record {
+    source: Arc<Source>,
+    stream: &'static str,
+    level: Level,
+    message: Bytes,
+}
+
+/// Queues the lines written by a guest to one of its streams.
+#[derive(Debug)]
+pub struct GuestLogger {
+    source: Arc<Source>,
+    stream: &'static str,
+    level: Level,
+}
+
+impl GuestLogger {
+    pub fn new(source: Arc<Source>, stream: &'static str, level: Level) -> Self {
+        Self {
+            source,
+            stream,
+            level,
+        }
+    }
+}
+
+impl Logger for GuestLogger {
+    fn log(&self, message: &[u8]) {
+        let record = Record {
+            source: self.source.clone(),
+            stream: self.stream,
+            level: self.level,
+            message: Bytes::copy_from_slice(message),
+        };
+
+        match QUEUE.get() {
+            Some(queue) => {
+                if let Err(err) = queue.try_send(record) {
+                    let record = match err {
+                        mpsc::error::TrySendError::Full(record) => record,
+                        mpsc::error::TrySendError::Closed(record) => record,
+                    };
+                    DROPPED.fetch_add(count_lines(&record.message), Ordering::Relaxed);
+                }
+            }
+            None => emit(&record, false),
+        }
+    }
+}
+
+/// A token bucket, refilled with `Limits::rate` lines per second.
+#[derive(Debug)]
+struct Bucket {
+    tokens: f64,
+    updated: Instant,
+    suppressed: u64,
+}
+
+impl Bucket {
+    fn new(limits: &Limits) -> Self {
+        Self {
+            tokens: limits.burst,
+            updated: Instant::now(),
+            suppressed: 0,
+        }
+    }
+
+    fn take(&mut self, limits: &Limits, lines: u64) -> bool {
+        // A single write may hold more lines than the burst, it still has to fit.
+        let lines = (lines as f64).min(limits.burst);
+        let now = Instant::now();
+        let elapsed = now.duration_since(self.updated).as_secs_f64();
+        self.tokens = (self.tokens + elapsed * limits.rate).min(limits.burst);
+        self.updated = now;
+
+        if self.tokens >= lines {
+            self.tokens -= lines;
+            true
+        } else {
+            false
+        }
+    }
+}
+
+/// How often the number of suppressed lines is reported.
+const REPORT_INTERVAL: Duration = Duration::from_secs(10);
+
+async fn drain(mut receiver: mpsc::Receiver<Record>, limits: Limits) {
+    let mut buckets: HashMap<Arc<str>, Bucket> = HashMap::new();
+    let mut report = tokio::time::interval(REPORT_INTERVAL);
+
+    loop {
+        let record = tokio::select! {
+            record = receiver.recv() => match record {
+                Some(record) => record,
+                None => break,
+            },
+            _ = report.tick() => {
+                report_suppressed(&mut buckets);
+                continue;
+            }
+        };
+
+        let bucket = buckets
+            .entry(record.source.script.clone())
+            .or_insert_with(|| Bucket::new(&limits));
+
+        let lines = count_lines(&record.message);
+        if bucket.take(&limits, lines) {
+            emit(&record, false);
+        } else {
+            let before = bucket.suppressed;
+            bucket.suppressed += lines;
+            if limits.sample > 0 && bucket.suppressed / limits.sample != before / limits.sample {
+                emit(&record, true);
+            }
+        }
+    }
+
+    report_suppressed(&mut buckets);
+}
+
+/// Logs the lines which were dropped or suppressed since the last report, and forgets the
+/// scripts which have been quiet since.
+fn report_suppressed(buckets: &mut HashMap<Arc<str>, Bucket>) {
+    let dropped = DROPPED.swap(0, Ordering::Relaxed);
+    if dropped > 0 {
+        tracing::warn!(dropped, "guest log queue is full, lines were dropped");
+    }
+
+    let now = Instant::now();
+    buckets.retain(|script, bucket| {
+        if bucket.suppressed > 0 {
+            tracing::warn!(
+                script = &**script,
+                suppressed = bucket.suppressed,
+                "guest log rate limit exceeded, lines were suppressed"
+            );
+            bucket.suppressed = 0;
+            return true;
+        }
+        now.duration_since(bucket.updated) < REPORT_INTERVAL
+    });
+}
+
+fn count_lines(message: &[u8]) -> u64 {
+    memchr::memchr_iter(b'\n', message).count() as u64 + 1
+}
+
+fn emit(record: &Record, sampled: bool) {
+    let message = String::from_utf8_lossy(&record.message);
+    let script = &*record.source.script;
+    let stream = record.stream;
+    let _enter = record.source.span.enter();
+
+    macro_rules! emit {
+        ($level:expr) => {
+            tracing::event!($level, script, stream, sampled, "{}", message)
+        };
+    }
+
+    match record.level {
+        Level::ERROR => emit!(Level::ERROR),
+        Level::WARN => emit!(Level::WARN),
+        Level::INFO => emit!(Level::INFO),
+        Level::DEBUG => emit!(Level::DEBUG),
+        Level::TRACE => emit!(Level::TRACE),
+    }
+}
@@ -2,6 +2,7 @@
 
 mod cgi;
 mod lambda;
+mod log;
 mod wasm;
 
 use axum::{routing::any, Router};
@@ -38,6 +39,7 @@ fn install_tracing() {
 #[tokio::main]
 async fn main() {
     install_tracing();
+    log::spawn();
 
     let mode = if env::var("WGI_MODE").map_or(false, |var| var == "lambda") {
         Mode::Lambda
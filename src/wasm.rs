@@ -1,54 +1,28 @@
 use crate::{
     cgi::CgiResponse,
-    lambda::{self, LambdaRequest, LambdaResponse},
+    lambda::{self, EventFormat, LambdaRequest, Responder},
+    log::{GuestLogger, Source},
 };
+use bytes::{Buf, Bytes, BytesMut};
 use std::{
     env,
     io::{self, Read, Seek, Write},
     path::PathBuf,
+    sync::Arc,
+    time::Instant,
 };
 use tracing::Level;
 use wasmer::{ChainableNamedResolver, DeserializeError, Instance, Module, Store, Triple, VERSION};
 use wasmer_cache::{Cache, FileSystemCache, Hash};
 use wasmer_compiler_cranelift::Cranelift;
 use wasmer_engine_universal::Universal;
-use wasmer_vfs::FsError;
+use wasmer_vfs::{FsError, Upcastable};
 use wasmer_wasi::{Pipe, VirtualFile, WasiState};
 
 pub trait Logger {
     fn log(&self, message: &[u8]);
 }
 
-#[derive(Debug)]
-pub struct TracingLogger {
-    level: Level,
-}
-
-impl TracingLogger {
-    pub fn new(level: Level) -> Self {
-        Self { level }
-    }
-}
-
-impl Default for TracingLogger {
-    fn default() -> Self {
-        Self::new(Level::INFO)
-    }
-}
-
-impl Logger for TracingLogger {
-    fn log(&self, message: &[u8]) {
-        let message = String::from_utf8_lossy(message);
-        match self.level {
-            Level::ERROR => tracing::error!("{}", message),
-            Level::WARN => tracing::warn!("{}", message),
-            Level::INFO => tracing::info!("{}", message),
-            Level::DEBUG => tracing::debug!("{}", message),
-            Level::TRACE => tracing::trace!("{}", message),
-        }
-    }
-}
-
 #[derive(Debug)]
 pub struct LogForwarder<L: Logger> {
     logger: L,
@@ -82,27 +56,22 @@ impl<L: Logger> Read for LogForwarder<L> {
 }
 
 impl<L: Logger> Write for LogForwarder<L> {
+    /// Forwards all the complete lines of a write as a single message.
     fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
-        match buf.iter().position(|&c| c == b'\n') {
+        match memchr::memrchr(b'\n', buf) {
             Some(pos) => {
-                let line = &buf[..pos];
+                let lines = &buf[..pos];
                 if self.incomplete.is_empty() {
-                    self.logger.log(line)
+                    self.logger.log(lines)
                 } else {
-                    self.incomplete.extend(line);
+                    self.incomplete.extend_from_slice(lines);
                     self.logger.log(&self.incomplete);
                     self.incomplete.clear();
                 }
 
-                let mut rest = &buf[pos + 1..];
-                while let Some(pos) = rest.iter().position(|&c| c == b'\n') {
-                    self.logger.log(&rest[..pos]);
-                    rest = &rest[pos + 1..];
-                }
-
-                self.incomplete.extend(rest);
+                self.incomplete.extend_from_slice(&buf[pos + 1..]);
             }
-            None => self.incomplete.extend(buf),
+            None => self.incomplete.extend_from_slice(buf),
         }
 
         Ok(buf.len())
@@ -153,15 +122,113 @@ impl<L: Logger + std::fmt::Debug + Send + 'static> VirtualFile for LogForwarder<
     }
 }
 
-pub struct App(Vec<u8>);
+/// Initial capacity of the buffer collecting the output of a CGI script. It matches the stdout
+/// buffer of `js.wasm`, so most responses fit without growing it.
+const OUTPUT_CAPACITY: usize = 64 * 1024;
+
+/// The stdout of a CGI script. The guest writes are appended to a single buffer which is handed
+/// over to the response without being copied. WASI's `fd_write` calls `write` once per iovec.
+#[derive(Debug)]
+pub struct OutputBuffer {
+    buf: BytesMut,
+}
+
+impl OutputBuffer {
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            buf: BytesMut::with_capacity(capacity),
+        }
+    }
+
+    pub fn into_bytes(self) -> Bytes {
+        self.buf.freeze()
+    }
+}
+
+impl Read for OutputBuffer {
+    fn read(&mut self, buf: &mut [u8]) -> io::Result<usize> {
+        let len = buf.len().min(self.buf.len());
+        buf[..len].copy_from_slice(&self.buf[..len]);
+        self.buf.advance(len);
+        Ok(len)
+    }
+}
+
+impl Write for OutputBuffer {
+    fn write(&mut self, buf: &[u8]) -> io::Result<usize> {
+        self.buf.extend_from_slice(buf);
+        Ok(buf.len())
+    }
+
+    fn flush(&mut self) -> io::Result<()> {
+        Ok(())
+    }
+}
+
+impl Seek for OutputBuffer {
+    fn seek(&mut self, _pos: io::SeekFrom) -> io::Result<u64> {
+        Err(io::Error::new(
+            io::ErrorKind::Other,
+            "can not seek in a pipe",
+        ))
+    }
+}
+
+impl VirtualFile for OutputBuffer {
+    fn last_accessed(&self) -> u64 {
+        0
+    }
+
+    fn last_modified(&self) -> u64 {
+        0
+    }
+
+    fn created_time(&self) -> u64 {
+        0
+    }
+
+    fn size(&self) -> u64 {
+        self.buf.len() as u64
+    }
+
+    fn set_len(&mut self, len: u64) -> Result<(), FsError> {
+        self.buf.resize(len as usize, 0);
+        Ok(())
+    }
+
+    fn unlink(&mut self) -> Result<(), FsError> {
+        Ok(())
+    }
+
+    fn bytes_available(&self) -> Result<usize, FsError> {
+        Ok(self.buf.len())
+    }
+}
+
+pub struct App {
+    wasm: Vec<u8>,
+    script: Arc<str>,
+}
 
 impl App {
-    pub fn new(wasm: Vec<u8>) -> Self {
-        Self(wasm)
+    /// `script` is the path the module was loaded from, it is attached to the lines it logs.
+    pub fn new(wasm: Vec<u8>, script: &str) -> Self {
+        Self {
+            wasm,
+            script: script.into(),
+        }
+    }
+
+    /// Called on the thread running the request, so the guest's lines end up in its span.
+    fn source(&self) -> Arc<Source> {
+        Arc::new(Source {
+            script: self.script.clone(),
+            span: tracing::Span::current(),
+        })
     }
 
     fn module(&self) -> anyhow::Result<Module> {
-        let hash = Hash::generate(&self.0);
+        let hash = Hash::generate(&self.wasm);
 
         let store = Store::new(&Universal::new(Cranelift::default()).engine());
         let mut cache = get_cache()?;
@@ -176,73 +243,113 @@ impl App {
                     }
                 }
 
-                let module = Module::from_binary(&store, &self.0)?;
+                // The cold start of a script, which depends on the size of its module.
+                let started = Instant::now();
+                let module = Module::from_binary(&store, &self.wasm)?;
+                tracing::info!(
+                    script = &*self.script,
+                    size = self.wasm.len(),
+                    compile_ms = started.elapsed().as_secs_f64() * 1000.0,
+                    "compiled module"
+                );
                 cache.store(hash, &module)?;
                 Ok(module)
             }
         }
     }
 
-    pub fn run_cgi(&self, input: &[u8], vars: &[(String, String)]) -> anyhow::Result<CgiResponse> {
+    /// The instantiation time, with the compile time logged by `module`, tells how a build of
+    /// the guest, e.g. `wasm-opt -O3` or `-Oz`, affects the cost of a request.
+    fn log_instantiation(&self, started: Instant) {
+        tracing::debug!(
+            script = &*self.script,
+            instantiate_ms = started.elapsed().as_secs_f64() * 1000.0,
+            "instantiated module"
+        );
+    }
+
+    /// Runs the module as a CGI script. `vars` are complete `KEY=VALUE` entries and are handed
+    /// to the WASI environment as-is.
+    pub fn run_cgi(&self, input: &[u8], mut vars: Vec<Vec<u8>>) -> anyhow::Result<CgiResponse> {
         let module = self.module()?;
+        if gc_stats_enabled() {
+            vars.push(b"JS_GC_STATS=1".to_vec());
+        }
 
         let stdin = Pipe::new();
-        let stdout = Pipe::new();
-        let stderr = LogForwarder::new(TracingLogger::default());
+        let stdout = OutputBuffer::with_capacity(OUTPUT_CAPACITY);
+        let stderr = LogForwarder::new(GuestLogger::new(self.source(), "stderr", Level::INFO));
         let mut builder = WasiState::new("wgi-bin");
         builder.stdin(Box::new(stdin));
         builder.stdout(Box::new(stdout));
         builder.stderr(Box::new(stderr));
         builder.preopen_dir(".")?;
-        for (key, value) in vars {
-            builder.env(key, value);
-        }
 
         let mut wasi_env = builder.finalize()?;
         let import_object = wasi_env.import_object(&module)?;
 
         {
             let mut state = wasi_env.state();
+            state.envs = vars;
+
             let wasi_stdin = state.fs.stdin_mut()?.as_mut().unwrap();
             wasi_stdin.write_all(input)?;
         }
 
+        let started = Instant::now();
         let instance = Instance::new(&module, &import_object)?;
+        self.log_instantiation(started);
         let run = instance.exports.get_native_function::<(), ()>("_start")?;
         run.call()?;
 
         let mut state = wasi_env.state();
-        let wasi_stdout = state.fs.stdout_mut()?.as_mut().unwrap();
-        let mut buf = String::new();
-        wasi_stdout.read_to_string(&mut buf)?;
-        Ok(buf.parse()?)
+        let wasi_stdout = state.fs.stdout_mut()?.take().unwrap();
+        let output = match wasi_stdout.upcast_any_box().downcast::<OutputBuffer>() {
+            Ok(output) => output.into_bytes(),
+            Err(_) => anyhow::bail!("stdout was replaced"),
+        };
+        Ok(CgiResponse::from(output))
     }
 
-    pub fn run_lamba(&self, request: LambdaRequest) -> anyhow::Result<Option<LambdaResponse>> {
-        let mut lambda_env = lambda::Env::new(request);
+    pub fn run_lamba(&self, request: LambdaRequest, responder: Responder) -> anyhow::Result<()> {
         let module = self.module()?;
+        let format = EventFormat::for_module(&module);
+        let mut lambda_env = lambda::Env::new(request, format, responder);
 
-        let stdout = LogForwarder::new(TracingLogger::default());
-        let stderr = LogForwarder::new(TracingLogger::default());
+        let source = self.source();
+        let stdout = LogForwarder::new(GuestLogger::new(source.clone(), "stdout", Level::INFO));
+        let stderr = LogForwarder::new(GuestLogger::new(source, "stderr", Level::INFO));
         let mut builder = WasiState::new("lambda");
         builder.stdout(Box::new(stdout));
         builder.stderr(Box::new(stderr));
         builder.preopen_dir(".")?;
+        if gc_stats_enabled() {
+            builder.env("JS_GC_STATS", "1");
+        }
 
         let mut wasi_env = builder.finalize()?;
         let import_object = wasi_env.import_object(&module)?;
 
         let chained_imports = lambda_env.import_object(&module).chain_back(import_object);
 
+        let started = Instant::now();
         let instance = Instance::new(&module, &chained_imports)?;
+        self.log_instantiation(started);
         let start = instance.exports.get_native_function::<(), ()>("_start")?;
-        start.call()?;
+        let result = start.call();
 
-        let response = lambda_env.state().response.take();
-        Ok(response)
+        lambda_env.finish();
+        result?;
+        Ok(())
     }
 }
 
+/// Set `WGI_GC_STATS` to have the JS runtimes log their garbage collector statistics with each
+/// request.
+fn gc_stats_enabled() -> bool {
+    env::var_os("WGI_GC_STATS").is_some()
+}
+
 fn get_cache() -> anyhow::Result<FileSystemCache> {
     let cache_dir_root = get_cache_dir();
     let mut cache = FileSystemCache::new(cache_dir_root)?;